@@ -0,0 +1,577 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-FileCopyrightText: 2026 KCachegrind Authors
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#include "tracedata.h"
+#include "loader.h"
+#include "config.h"
+#include "globalconfig.h"
+#include "logger.h"
+
+/*
+ * Benchmark for loading of profile data with libcore.
+ *
+ * Generates a synthetic callgrind file of configurable shape (or uses
+ * given files), and measures the phases of loading it: parsing by the
+ * loader, cycle detection, the update of inclusive costs and the
+ * update after deactivating and activating a part.
+ * Also reports the hit rate of the event value cache of cost items
+ * when repainting a list showing two event types.
+ */
+
+// parameters of the synthetic profile
+struct Shape
+{
+    int functions = 10000;
+    int calls = 4;      // calls per function
+    int lines = 8;      // cost lines per function
+    int events = 4;
+    int parts = 1;
+    bool compress = true;
+    bool instr = false;
+    quint64 seed = 1;
+};
+
+static const char* eventNames[] = {
+    "Ir", "Dr", "Dw", "I1mr", "D1mr", "D1mw", "ILmr", "DLmr", "DLmw",
+    "Bc", "Bcm", "Bi", "Bim"
+};
+static const int eventNameCount = sizeof(eventNames) / sizeof(eventNames[0]);
+
+// functions per source file, and source files per ELF object
+#define FUNCTIONS_PER_FILE 20
+#define FILES_PER_OBJECT 50
+
+// write buffer size for generated file
+#define WRITE_BUFFER_SIZE (1024*1024)
+
+
+// xorshift64*, to get the same file for the same seed everywhere
+class Random
+{
+public:
+    explicit Random(quint64 seed) { _state = seed ? seed : 1; }
+
+    quint64 next()
+    {
+        _state ^= _state >> 12;
+        _state ^= _state << 25;
+        _state ^= _state >> 27;
+        return _state * 2685821657736338717ULL;
+    }
+    int below(int n) { return (int) (next() % (quint64) n); }
+
+private:
+    quint64 _state;
+};
+
+
+/**
+ * Writer for a synthetic profile data file with shape @p s.
+ */
+class Generator
+{
+public:
+    Generator(const Shape& s, QFile* file)
+        : _shape(s), _file(file), _random(s.seed)
+    {
+        _lines = 0;
+        _buffer.reserve(WRITE_BUFFER_SIZE + 4096);
+    }
+
+    bool write();
+    qint64 lines() const { return _lines; }
+
+private:
+    int fileOf(int f) const { return f / FUNCTIONS_PER_FILE; }
+    int objectOf(int f) const { return fileOf(f) / FILES_PER_OBJECT; }
+    int firstLine(int f) const { return (f % FUNCTIONS_PER_FILE) * 100 + 1; }
+    quint64 addr(int f, int l) const
+    { return 0x400000ULL + (quint64) f * 0x1000 + (quint64) l * 4; }
+
+    void writePart(int part);
+    void name(const char* prefix, int id, QVector<bool>& defined,
+              const QByteArray& n);
+    void position(int f, int l);
+    void costs(bool inclusive, QVector<quint64>* sum);
+    void endLine();
+    bool flush(bool force);
+
+    QByteArray objectName(int o) const
+    { return "/usr/lib/libsynth" + QByteArray::number(o) + ".so"; }
+    QByteArray fileName(int fl) const
+    {
+        return "/home/user/src/synth/module" +
+               QByteArray::number(fl / FILES_PER_OBJECT) +
+               "/file" + QByteArray::number(fl) + ".cpp";
+    }
+    QByteArray functionName(int f) const
+    {
+        return "ns" + QByteArray::number(f % 17) +
+               "::Class" + QByteArray::number(f / FUNCTIONS_PER_FILE) +
+               "::method" + QByteArray::number(f) +
+               "(int, std::vector<int, std::allocator<int> > const&)";
+    }
+
+    Shape _shape;
+    QFile* _file;
+    Random _random;
+    QByteArray _buffer;
+    qint64 _lines;
+    bool _error = false;
+};
+
+bool Generator::flush(bool force)
+{
+    if (!force && (_buffer.size() < WRITE_BUFFER_SIZE)) return true;
+
+    if (_file->write(_buffer) != _buffer.size()) _error = true;
+    _buffer.clear();
+    return !_error;
+}
+
+void Generator::endLine()
+{
+    _buffer += '\n';
+    _lines++;
+}
+
+// name specification, using compression "(id) name" if enabled
+void Generator::name(const char* prefix, int id, QVector<bool>& defined,
+                     const QByteArray& n)
+{
+    _buffer += prefix;
+    if (_shape.compress) {
+        _buffer += '(' + QByteArray::number(id + 1) + ')';
+        if (!defined[id]) {
+            defined[id] = true;
+            _buffer += ' ' + n;
+        }
+    }
+    else
+        _buffer += n;
+    endLine();
+}
+
+void Generator::position(int f, int l)
+{
+    if (_shape.instr) {
+        _buffer += "0x" + QByteArray::number(addr(f, l), 16) + ' ';
+    }
+    _buffer += QByteArray::number(firstLine(f) + l);
+}
+
+void Generator::costs(bool inclusive, QVector<quint64>* sum)
+{
+    for(int e = 0; e < _shape.events; e++) {
+        // first event (Ir) dominates, misses are rare
+        int range = (e == 0) ? 10000 : 1000 / (e + 1);
+        if (inclusive) range *= 100;
+        quint64 v = _random.below(range) + ((e == 0) ? 1 : 0);
+        _buffer += ' ' + QByteArray::number(v);
+        if (sum) (*sum)[e] += v;
+    }
+    endLine();
+}
+
+void Generator::writePart(int part)
+{
+    QVector<bool> objectDefined(objectOf(_shape.functions - 1) + 1, false);
+    QVector<bool> fileDefined(fileOf(_shape.functions - 1) + 1, false);
+    QVector<bool> functionDefined(_shape.functions, false);
+    QVector<quint64> totals(_shape.events, 0);
+
+    _buffer += "part: " + QByteArray::number(part + 1);
+    endLine();
+    _buffer += _shape.instr ? "positions: instr line" : "positions: line";
+    endLine();
+    _buffer += "events:";
+    for(int e = 0; e < _shape.events; e++) {
+        _buffer += ' ';
+        if (e < eventNameCount)
+            _buffer += eventNames[e];
+        else
+            _buffer += "Ev" + QByteArray::number(e);
+    }
+    endLine();
+    endLine();
+
+    int currentObject = -1, currentFile = -1;
+    for(int f = 0; f < _shape.functions; f++) {
+        if (objectOf(f) != currentObject) {
+            currentObject = objectOf(f);
+            name("ob=", currentObject, objectDefined, objectName(currentObject));
+        }
+        if (fileOf(f) != currentFile) {
+            currentFile = fileOf(f);
+            name("fl=", currentFile, fileDefined, fileName(currentFile));
+        }
+        name("fn=", f, functionDefined, functionName(f));
+
+        for(int l = 0; l < _shape.lines; l++) {
+            position(f, l);
+            costs(false, &totals);
+
+            for(int c = l; c < _shape.calls; c += _shape.lines) {
+                // mostly calls down the tree, some random ones giving cycles
+                int target;
+                if (_random.below(5) > 0)
+                    target = (f + 1 + _random.below(50)) % _shape.functions;
+                else
+                    target = _random.below(_shape.functions);
+
+                if (objectOf(target) != currentObject)
+                    name("cob=", objectOf(target), objectDefined,
+                         objectName(objectOf(target)));
+                if (fileOf(target) != currentFile)
+                    name("cfi=", fileOf(target), fileDefined,
+                         fileName(fileOf(target)));
+                name("cfn=", target, functionDefined, functionName(target));
+
+                _buffer += "calls=" + QByteArray::number(1 + _random.below(1000)) + ' ';
+                if (_shape.instr)
+                    _buffer += "0x" + QByteArray::number(addr(target, 0), 16) + ' ';
+                _buffer += QByteArray::number(firstLine(target));
+                endLine();
+                position(f, l);
+                costs(true, nullptr);
+            }
+            if (!flush(false)) return;
+        }
+    }
+
+    _buffer += "totals:";
+    for(int e = 0; e < _shape.events; e++)
+        _buffer += ' ' + QByteArray::number(totals[e]);
+    endLine();
+    endLine();
+}
+
+bool Generator::write()
+{
+    _buffer += "# callgrind format";
+    endLine();
+    _buffer += "version: 1";
+    endLine();
+    _buffer += "creator: cgbench";
+    endLine();
+    _buffer += "cmd: synthetic";
+    endLine();
+
+    for(int p = 0; p < _shape.parts; p++) {
+        writePart(p);
+        if (_error) return false;
+    }
+    return flush(true);
+}
+
+
+// logger only showing errors, to not disturb timing output
+class BenchLogger: public Logger
+{
+public:
+    void loadStart(const QString& filename) override { _filename = filename; }
+    void loadProgress(int) override {}
+    void loadWarning(int, const QString&) override {}
+    void loadFinished(const QString& msg) override
+    {
+        if (!msg.isEmpty())
+            QTextStream(stderr) << "Error loading " << _filename
+                                << ": " << msg << "\n";
+    }
+};
+
+
+// peak resident set size of this process in kB, -1 if unknown
+static long peakRSS()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#ifdef Q_OS_MACOS
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return -1;
+#endif
+}
+
+static qint64 countLines(const QString& filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) return 0;
+
+    qint64 lines = 0;
+    QByteArray block;
+    while(!(block = file.read(WRITE_BUFFER_SIZE)).isEmpty())
+        lines += block.count('\n');
+    return lines;
+}
+
+void showHelp(QTextStream& out, bool fullHelp = true)
+{
+    out <<  "Benchmark loading of callgrind files with libcore.\n";
+
+    if (!fullHelp)
+        out << "Type 'cgbench -h' for help.\n";
+    else
+        out << "Usage: cgbench [options] [<file> ...]\n\n"
+               "Without files, a synthetic profile is generated and loaded.\n\n"
+               "Options:\n"
+               " -h        Show this help text\n"
+               " -f <n>    Number of functions (default: 10000)\n"
+               " -c <n>    Calls per function (default: 4)\n"
+               " -l <n>    Cost lines per function (default: 8)\n"
+               " -e <n>    Number of event types (default: 4)\n"
+               " -p <n>    Number of parts (default: 1)\n"
+               " -n        Do not use name compression\n"
+               " -i        Use instruction positions (\"positions: instr line\")\n"
+               " -s <n>    Seed for generated costs and calls (default: 1)\n"
+               " -o <file> Write generated profile to <file> and keep it\n"
+               " -r <n>    Number of runs (default: 3)\n"
+               " -j <n>    Threads for loading and updating (default: CPU cores)\n"
+               " -x        Use prefix sums over parts for ranges of active parts\n";
+
+    exit(1);
+}
+
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    Loader::initLoaders();
+    ConfigStorage::setStorage(new ConfigStorage);
+    GlobalConfig::config()->addDefaultTypes();
+
+    QStringList list = app.arguments();
+    list.pop_front();
+
+    Shape shape;
+    QString output;
+    int runs = 3;
+    QStringList files;
+
+    int arg;
+    // value of an option
+    auto value = [&]() {
+        if (arg+1 >= list.count()) showHelp(out, false);
+        return list[++arg];
+    };
+
+    for(arg = 0; arg<list.count(); arg++) {
+        if      (list[arg] == QLatin1String("-h")) showHelp(out);
+        else if (list[arg] == QLatin1String("-n")) shape.compress = false;
+        else if (list[arg] == QLatin1String("-i")) shape.instr = true;
+        else if (list[arg] == QLatin1String("-f")) shape.functions = value().toInt();
+        else if (list[arg] == QLatin1String("-c")) shape.calls = value().toInt();
+        else if (list[arg] == QLatin1String("-l")) shape.lines = value().toInt();
+        else if (list[arg] == QLatin1String("-e")) shape.events = value().toInt();
+        else if (list[arg] == QLatin1String("-p")) shape.parts = value().toInt();
+        else if (list[arg] == QLatin1String("-s")) shape.seed = value().toULongLong();
+        else if (list[arg] == QLatin1String("-o")) output = value();
+        else if (list[arg] == QLatin1String("-r")) runs = value().toInt();
+        else if (list[arg] == QLatin1String("-x")) GlobalConfig::setPartPrefixSums(true);
+        else if (list[arg] == QLatin1String("-j"))
+            GlobalConfig::config()->setLoadThreads(value().toInt());
+        else
+            files << list[arg];
+    }
+
+    if ((shape.functions < 1) || (shape.calls < 0) || (shape.lines < 1) ||
+        (shape.events < 1) || (shape.parts < 1) || (runs < 1)) {
+        out << "Error: invalid profile shape or number of runs.\n";
+        return 1;
+    }
+
+    // generated file is removed at end if not requested with -o
+    bool removeOutput = files.isEmpty() && output.isEmpty();
+    qint64 lines = 0;
+    if (files.isEmpty()) {
+        if (output.isEmpty())
+            output = QDir::tempPath() + QStringLiteral("/cgbench-%1.out")
+                     .arg(QCoreApplication::applicationPid());
+        QFile file(output);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            out << "Error: cannot write '" << output << "'.\n";
+            return 1;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        Generator g(shape, &file);
+        bool ok = g.write();
+        file.close();
+        if (!ok) {
+            out << "Error: writing '" << output << "' failed.\n";
+            QFile::remove(output);
+            return 1;
+        }
+        lines = g.lines();
+
+        out << "Generated " << output << " in " << timer.elapsed() << " ms:\n"
+            << "  " << shape.functions << " functions, "
+            << shape.calls << " calls and " << shape.lines
+            << " cost lines per function, " << shape.events << " events, "
+            << shape.parts << " parts, "
+            << (shape.compress ? "" : "no ") << "name compression, "
+            << (shape.instr ? "instr line" : "line") << " positions\n";
+        files << output;
+    }
+
+    qint64 bytes = 0;
+    bool count = (lines == 0);
+    foreach(const QString& f, files) {
+        bytes += QFileInfo(f).size();
+        if (count) lines += countLines(f);
+    }
+    out << "Input: " << files.count() << " file(s), "
+        << QString::number(bytes / 1048576.0, 'f', 1) << " MB, "
+        << lines << " lines\n\n";
+
+    out << "  run   load [ms]      MB/s     lines/s  cycles [ms]  update [ms]  toggle [ms]   range [ms]  peak RSS [kB]\n";
+
+    bool showCycles = GlobalConfig::showCycles();
+    qint64 bestLoad = -1, bestCycles = -1, bestUpdate = -1, bestToggle = -1;
+    qint64 bestRange = -1;
+    quint64 cacheHits = 0, cacheMisses = 0;
+    for(int run = 1; run <= runs; run++) {
+        TraceData* d = new TraceData(new BenchLogger);
+        QElapsedTimer timer;
+
+        // loading includes cycle detection, which is measured separately
+        GlobalConfig::setShowCycles(false);
+        timer.start();
+        int parts;
+        if (files.count() == 1) {
+            // not as prefix, see TraceData::load(QStringList)
+            QFile file(files[0]);
+            parts = d->load(&file, files[0]);
+        }
+        else
+            parts = d->load(files);
+        qint64 loadTime = timer.elapsed();
+        GlobalConfig::setShowCycles(showCycles);
+        if (parts == 0) {
+            out << "Error: no parts loaded.\n";
+            delete d;
+            if (removeOutput) QFile::remove(output);
+            return 1;
+        }
+
+        timer.start();
+        d->updateFunctionCycles();
+        qint64 cyclesTime = timer.elapsed();
+
+        // what views do first: totals and inclusive costs of functions
+        timer.start();
+        d->invalidateDynamicCost();
+        d->updateAll();
+        EventType* et = d->eventTypes()->realType(0);
+        TraceFunctionMap& functions = d->functionMap();
+        for(int i = 0; i < functions.count(); i++)
+            functions.at(i).inclusive()->subCost(et);
+        qint64 updateTime = timer.elapsed();
+
+        // what a function list does on repaint: show a primary and a
+        // secondary event type for each row
+        EventTypeSet* types = d->eventTypes();
+        EventType* et2 = (types->derivedCount() > 0) ? types->derivedType(0) :
+                         types->realType(types->realCount() - 1);
+        ProfileCostArray::resetCacheCounters();
+        ProfileCostArray::setCacheCounting(true);
+        for(int paint = 0; paint < 2; paint++)
+            for(int i = 0; i < functions.count(); i++) {
+                ProfileCostArray* incl = functions.at(i).inclusive();
+                incl->subCost(et);
+                incl->subCost(et2);
+            }
+        ProfileCostArray::setCacheCounting(false);
+        cacheHits = ProfileCostArray::cacheHits();
+        cacheMisses = ProfileCostArray::cacheMisses();
+
+        // what a click in the part selection does: deactivate the first
+        // part and update the views, then activate it again
+        timer.start();
+        TracePartList first;
+        first.append(d->parts().first());
+        for(int active = 0; active < 2; active++) {
+            d->activateParts(first, active == 1);
+            d->subCost(et);
+            for(int i = 0; i < functions.count(); i++)
+                functions.at(i).inclusive()->subCost(et);
+            TraceObjectMap& objects = d->objectMap();
+            for(int i = 0; i < objects.count(); i++)
+                objects.at(i).subCost(et);
+        }
+        qint64 toggleTime = timer.elapsed();
+
+        // what dragging a time range in the part selection does: move a
+        // window over half of the parts by one part per step
+        timer.start();
+        TracePartList all = d->parts();
+        int window = qMax(1, (int) all.count() / 2);
+        for(int start = 0; start + window <= all.count(); start++) {
+            d->activateParts(all.mid(start, window));
+            for(int i = 0; i < functions.count(); i++)
+                functions.at(i).inclusive()->subCost(et);
+        }
+        d->activateAll();
+        qint64 rangeTime = timer.elapsed();
+
+        double secs = qMax(loadTime, (qint64) 1) / 1000.0;
+        out.setFieldAlignment(QTextStream::AlignRight);
+        out.setFieldWidth(5);  out << run;
+        out.setFieldWidth(12); out << loadTime;
+        out.setFieldWidth(10); out << QString::number(bytes / 1048576.0 / secs, 'f', 1);
+        out.setFieldWidth(12); out << (qint64) (lines / secs);
+        out.setFieldWidth(13); out << cyclesTime;
+        out.setFieldWidth(13); out << updateTime;
+        out.setFieldWidth(13); out << toggleTime;
+        out.setFieldWidth(13); out << rangeTime;
+        out.setFieldWidth(15); out << peakRSS();
+        out.setFieldWidth(0);  out << "\n";
+        out.flush();
+
+        if ((bestLoad < 0) || (loadTime < bestLoad)) bestLoad = loadTime;
+        if ((bestCycles < 0) || (cyclesTime < bestCycles)) bestCycles = cyclesTime;
+        if ((bestUpdate < 0) || (updateTime < bestUpdate)) bestUpdate = updateTime;
+        if ((bestToggle < 0) || (toggleTime < bestToggle)) bestToggle = toggleTime;
+        if ((bestRange < 0) || (rangeTime < bestRange)) bestRange = rangeTime;
+
+        delete d;
+    }
+
+    double secs = qMax(bestLoad, (qint64) 1) / 1000.0;
+    out << "\nBest: load " << bestLoad << " ms ("
+        << QString::number(bytes / 1048576.0 / secs, 'f', 1) << " MB/s, "
+        << (qint64) (lines / secs) << " lines/s), cycles "
+        << bestCycles << " ms, update " << bestUpdate << " ms, toggle "
+        << bestToggle << " ms, range " << bestRange << " ms\n";
+    quint64 accesses = qMax(cacheHits + cacheMisses, (quint64) 1);
+    out << "Event value cache on repaint: "
+        << QString::number(100.0 * cacheHits / accesses, 'f', 1) << "% hits ("
+        << cacheHits << " hits, " << cacheMisses << " misses)\n";
+
+    if (removeOutput) QFile::remove(output);
+
+    return 0;
+}
@@ -10,6 +10,7 @@
 #include <QTextStream>
 
 #include "tracedata.h"
+#include "fixcost.h"
 #include "loader.h"
 #include "config.h"
 #include "globalconfig.h"
@@ -33,11 +34,63 @@ void showHelp(QTextStream& out, bool fullHelp = true)
                " -s <ev>   Sort and show counters for event <ev>\n"
                " -c        Sort by call count\n"
                " -b        Show butterfly (callers and callees)\n"
-               " -n        Do not detect recursive cycles\n";
+               " -n        Do not detect recursive cycles\n"
+               " -j <n>    Load files with <n> threads (default: CPU cores)\n"
+               " -C        Use and write binary cache of loaded files\n"
+               " -S        Load function summaries only, no line/instruction detail\n"
+               " -E <evs>  Only load events in comma-separated list <evs>\n"
+               " -M        Show memory used for cost items of loaded files\n";
 
     exit(1);
 }
 
+// memory taken by fix cost items, with and without compact encoding
+void showMemory(QTextStream& out, TraceData* d)
+{
+    int items = 0;
+    quint64 raw = 0, encoded = 0;
+
+    TraceFunctionMap& functions = d->functionMap();
+    for(int i = 0; i < functions.count(); i++) {
+        foreach(TraceInclusiveCost* dep, functions.at(i).deps()) {
+            TracePartFunction* pf = (TracePartFunction*) dep;
+            for (FixCost* fc = pf->firstFixCost(); fc; fc = fc->nextCostOfPartFunction()) {
+                items++;
+                raw += fc->rawSize();
+                encoded += fc->encodedSize();
+            }
+            foreach(TracePartCall* pc, pf->partCallings())
+                for (FixCallCost* fcc = pc->firstFixCallCost(); fcc;
+                     fcc = fcc->nextCostOfPartCall()) {
+                    items++;
+                    raw += fcc->rawSize();
+                    encoded += fcc->encodedSize();
+                }
+        }
+    }
+
+    FixPool* pool = d->fixPool();
+    quint64 poolSize = pool->size();
+    out << "\nMemory of fix cost pool:\n"
+        << "  " << pool->count() << " allocations, " << poolSize / 1024
+        << " kB used, " << (quint64) pool->chunkSize() / 1024 << " kB allocated\n"
+        << "  " << items << " cost items: counters " << encoded / 1024
+        << " kB, " << raw / 1024 << " kB without compact encoding\n"
+        << "  pool without compact encoding: "
+        << (poolSize - encoded + raw) / 1024 << " kB\n";
+
+    out << "Memory of item pools:\n";
+    for (int t = 0; t < ProfileContext::MaxType; t++) {
+        FixPool* p = d->itemPool((ProfileContext::Type) t);
+        if (p->count() == 0) continue;
+        out << "  " << ProfileContext::typeName((ProfileContext::Type) t)
+            << ": " << p->count() << " items, " << (quint64) p->size() / 1024
+            << " kB used, " << (quint64) p->chunkSize() / 1024
+            << " kB allocated\n";
+    }
+    out << "\n";
+}
+
 
 int main(int argc, char** argv)
 {
@@ -55,6 +108,7 @@ int main(int argc, char** argv)
     bool sortByExcl = false;
     bool sortByCount = false;
     bool showCalls = false;
+    bool memory = false;
     QString showEvent;
     QStringList files;
 
@@ -65,6 +119,13 @@ int main(int argc, char** argv)
         else if (list[arg] == QLatin1String("-b")) showCalls = true;
         else if (list[arg] == QLatin1String("-c")) sortByCount = true;
         else if (list[arg] == QLatin1String("-s")) showEvent = list[++arg];
+        else if (list[arg] == QLatin1String("-C")) GlobalConfig::setUseLoadCache(true);
+        else if (list[arg] == QLatin1String("-S")) GlobalConfig::setLoadDetailOnDemand(true);
+        else if (list[arg] == QLatin1String("-j"))
+            GlobalConfig::config()->setLoadThreads(list[++arg].toInt());
+        else if (list[arg] == QLatin1String("-M")) memory = true;
+        else if (list[arg] == QLatin1String("-E"))
+            GlobalConfig::setLoadEvents(list[++arg].split(',', Qt::SkipEmptyParts));
         else
             files << list[arg];
     }
@@ -99,6 +160,16 @@ int main(int argc, char** argv)
     }
     out << "\n";
 
+    if (GlobalConfig::showCycles()) {
+        int cycles = 0;
+        foreach(TraceFunctionCycle* c, d->functionCycles())
+            if (!c->members().isEmpty()) cycles++;
+        out << "Cycle detection: " << cycles << " cycles in "
+            << d->functionCycleTime() << " ms\n\n";
+    }
+
+    if (memory) showMemory(out, d);
+
     if (showEvent.isEmpty())
         et = m->realType(0);
     else {
@@ -23,12 +23,15 @@
 #include <QEventLoop>
 #include <QFile>
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QLabel>
 #include <QLineEdit>
 #include <QMenu>
 #include <QMimeDatabase>
 #include <QProcess>
 #include <QProgressBar>
+#include <QRegularExpression>
+#include <QPushButton>
 #include <QStatusBar>
 #include <QTemporaryFile>
 #include <QTimer>
@@ -68,6 +71,7 @@
 #include "configdlg.h"
 #include "multiview.h"
 #include "callgraphview.h"
+#include "loadthread.h"
 
 TopLevel::TopLevel()
     : KXmlGuiWindow(nullptr)
@@ -78,7 +82,16 @@ TopLevel::TopLevel()
     _statusbar = statusBar();
     _statusLabel = new QLabel(_statusbar);
     _statusbar->addWidget(_statusLabel, 1);
+    _cancelButton = new QPushButton(QIcon::fromTheme(QStringLiteral("process-stop")),
+                                    i18n("Cancel"), _statusbar);
+    _cancelButton->setToolTip(i18n("Cancel loading of profile data"));
+    _statusbar->addPermanentWidget(_cancelButton);
+    _cancelButton->hide();
+    connect(_cancelButton, &QPushButton::clicked, this, &TopLevel::cancelLoad);
+    _loadThread = nullptr;
     _ccProcess = nullptr;
+    _followTimer = new QTimer(this);
+    connect(_followTimer, &QTimer::timeout, this, &TopLevel::followTimeout);
 
     _layoutCount = 1;
     _layoutCurrent = 0;
@@ -337,6 +350,11 @@ void TopLevel::createDocks()
 
 TopLevel::~TopLevel()
 {
+    // a running load finishes in the background
+    if (_loadThread) {
+        _loadThread->disconnect(this);
+        _loadThread->discard();
+    }
     delete _data;
 }
 
@@ -419,6 +437,15 @@ void TopLevel::createMiscActions()
                 "<p>This opens an additional profile data file in the current window.</p>");
     action->setWhatsThis( hint );
 
+    action = actionCollection()->addAction( QStringLiteral("file_load_events") );
+    action->setText( i18n( "Select &Events to Load..." ) );
+    connect(action, &QAction::triggered, this, &TopLevel::selectLoadEvents);
+    hint = i18n("<b>Select Events to Load</b>"
+                "<p>Only the given event types are loaded from profile data "
+                "files opened afterwards. This reduces memory usage for "
+                "profiles with many event types.</p>");
+    action->setWhatsThis( hint );
+
     action = actionCollection()->addAction( QStringLiteral("reload") );
     action->setIcon( QIcon::fromTheme(QStringLiteral("view-refresh")) );
     action->setText( i18nc("Reload a document", "&Reload" ) );
@@ -467,6 +494,18 @@ void TopLevel::createMiscActions()
                 "of the program.</p>");
     _taDump->setWhatsThis( hint );
 
+    _taFollow = actionCollection()->add<KToggleAction>( QStringLiteral("follow") );
+    _taFollow->setText( i18n( "F&ollow Growing Files" ) );
+    connect(_taFollow, &QAction::triggered, this, &TopLevel::toggleFollow);
+    hint = i18n("<b>Follow Growing Files</b>"
+                "<p>Callgrind appends parts to its output file while "
+                "running, e.g. with option --dump-every-bb or on "
+                "'callgrind_control -d'. If checked, the loaded "
+                "files are checked every second, and only new "
+                "complete parts are loaded and selected.</p>"
+                "<p>Checking this reloads the current trace once.</p>");
+    _taFollow->setWhatsThis( hint );
+
     action = KStandardAction::open(this, SLOT(load()), actionCollection());
     hint = i18n("<b>Open Profile Data</b>"
                 "<p>This opens a profile data file, with possible multiple parts</p>");
@@ -945,11 +984,7 @@ void TopLevel::load(QString file)
         return;
     }
 
-    bool loaded = openDataFile(file);
-    if (!loaded && showError)
-        KMessageBox::error(this, i18n("Could not open the file \"%1\". "
-                                      "Check it exists and you have enough "
-                                      "permissions to read it.", file));
+    openDataFile(file, showError);
 }
 
 
@@ -1023,9 +1058,7 @@ void TopLevel::loadTraceDelayed()
 
     if (_loadFilesDelayed.count()>1) {
         // FIXME: we expect all files to be local and existing
-        TraceData* d = new TraceData(this);
-        d->load(_loadFilesDelayed);
-        setData(d);
+        startLoad(new LoadThread(_loadFilesDelayed, nullptr, this), false);
     }
     else {
         QString file = _loadFilesDelayed[0];
@@ -1053,6 +1086,20 @@ void TopLevel::reload()
     openDataFile(trace);
 }
 
+void TopLevel::selectLoadEvents()
+{
+    bool ok;
+    QString events = GlobalConfig::loadEvents().join(QLatin1Char(' '));
+    events = QInputDialog::getText(this, i18n("Select Events to Load"),
+                                   i18n("Event types to load from the next "
+                                        "opened files (empty for all):"),
+                                   QLineEdit::Normal, events, &ok);
+    if (!ok) return;
+
+    GlobalConfig::setLoadEvents(events.split(QRegularExpression(QStringLiteral("[\\s,]+")),
+                                             Qt::SkipEmptyParts));
+}
+
 void TopLevel::exportGraph()
 {
     if (!_data || !_function) return;
@@ -2084,6 +2131,45 @@ void TopLevel::ccExit(int exitCode, QProcess::ExitStatus s)
     QTimer::singleShot( 1000, this, &TopLevel::reload );
 }
 
+void TopLevel::toggleFollow()
+{
+    if (!_taFollow->isChecked()) {
+        _followTimer->stop();
+        return;
+    }
+
+    // positions in files are only known when loaded in follow mode
+    if (_data && !_data->follow())
+        reload();
+    _followTimer->start(1000);
+}
+
+void TopLevel::followTimeout()
+{
+    if (!_data) return;
+
+    TracePartList oldParts = _data->parts();
+    if (_data->loadAppended() == 0) return;
+
+    // new parts get selected in addition to the already active ones
+    TracePartList newActive = _activeParts;
+    foreach(TracePart* part, _data->parts())
+        if (!oldParts.contains(part))
+            newActive.append(part);
+
+    // recreates part items of the part overview
+    _partSelection->hiddenPartsChangedSlot(_hiddenParts);
+    _data->activateParts(newActive);
+    _activeParts = newActive;
+
+    _partSelection->set(newActive);
+    _multiView->set(newActive);
+    _functionSelection->set(newActive);
+    _stackSelection->refresh();
+
+    updateStatusBar();
+}
+
 void TopLevel::forwardAboutToShow()
 {
     QMenu *popup = _paForward->popupMenu();
@@ -2333,10 +2419,9 @@ void TopLevel::loadWarning(int line, const QString& msg)
     qWarning() << "Loading" << _filename << ":" << line << ": " << msg;
 }
 
-bool TopLevel::openDataFile(const QString& file)
+void TopLevel::openDataFile(const QString& file, bool showError)
 {
-    TraceData* d = new TraceData(this);
-    int filesLoaded;
+    QIODevice* device = nullptr;
 
     // see whether this file is compressed, than take the direct route
     QMimeDatabase dataBase;
@@ -2346,19 +2431,76 @@ bool TopLevel::openDataFile(const QString& file)
     KCompressionDevice* compressed;
     compressed = new KCompressionDevice(file,
                                         compressionType);
-    if (compressed &&
-        (compressed->compressionType() != KCompressionDevice::None)) {
-        filesLoaded = d->load(compressed, file);
-    } else {
+    if (compressed->compressionType() != KCompressionDevice::None)
+        device = compressed;
+    else {
         // else fallback to string based method that can also find multi-part callgrind data.
-        filesLoaded = d->load(file);
+        delete compressed;
+    }
+
+    startLoad(new LoadThread(QStringList(file), device, this), showError);
+}
+
+void TopLevel::startLoad(LoadThread* thread, bool showError)
+{
+    if (_loadThread) {
+        // no notifications from the replaced load any more
+        _loadThread->disconnect(this);
+        _loadThread->discard();
+        showStatus(QString(), 0);
+    }
+    _loadThread = thread;
+    thread->data()->setFollow(_taFollow->isChecked());
+
+    // loader notifications are queued into the GUI thread
+    connect(thread, &LoadThread::startedFile, this, &TopLevel::loadStart);
+    connect(thread, &LoadThread::progressed, this, &TopLevel::loadProgress);
+    connect(thread, &LoadThread::warning, this, &TopLevel::loadWarning);
+    connect(thread, &LoadThread::error, this, &TopLevel::loadError);
+    connect(thread, &LoadThread::finishedFile, this, &TopLevel::loadFinished);
+    // a replaced thread is deleted only after this was delivered (see
+    // LoadThread::discard()), so no new thread can be at its address
+    connect(thread, &QThread::finished, this, [this, thread, showError]() {
+        loadThreadFinished(thread, showError);
+    });
+
+    _cancelButton->show();
+    thread->start();
+}
+
+void TopLevel::loadThreadFinished(LoadThread* thread, bool showError)
+{
+    if (thread != _loadThread) return;
+    _loadThread = nullptr;
+    _cancelButton->hide();
+    showStatus(QString(), 0);
+
+    // views only get to see completely loaded data
+    TraceData* d = thread->takeData(this);
+    int partsLoaded = thread->partsLoaded();
+    QString file = thread->files().value(0);
+    thread->deleteLater();
+
+    if (!d) {
+        showMessage(i18n("Loading canceled"), 2000);
+        return;
     }
-    if (filesLoaded > 0) {
+    if (partsLoaded > 0) {
         setData(d);
-        return true;
-    } else {
-        return false;
+        return;
     }
+
+    delete d;
+    if (showError)
+        KMessageBox::error(this, i18n("Could not open the file \"%1\". "
+                                      "Check it exists and you have enough "
+                                      "permissions to read it.", file));
+}
+
+void TopLevel::cancelLoad()
+{
+    if (_loadThread)
+        _loadThread->cancel();
 }
 
 #include "moc_toplevel.cpp"
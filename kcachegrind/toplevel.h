@@ -30,6 +30,8 @@ class QLineEdit;
 class QDockWidget;
 class QLabel;
 class QProgressBar;
+class QPushButton;
+class QTimer;
 class QMenu;
 
 class QUrl;
@@ -40,6 +42,7 @@ class KStatusBar;
 
 class TraceData;
 class KRecentFilesAction;
+class LoadThread;
 class MainWidget;
 class PartSelection;
 class FunctionSelection;
@@ -100,6 +103,7 @@ public Q_SLOTS:
 
     void reload();
     void exportGraph();
+    void selectLoadEvents();
     void newWindow();
     void configure();
     void querySlot();
@@ -140,6 +144,9 @@ public Q_SLOTS:
     void toggleCycles();
     void toggleHideTemplates();
     void forceTrace();
+    void toggleFollow();
+    void followTimeout();
+    void cancelLoad();
     void forwardAboutToShow();
     void forwardTriggered(QAction*);
     void backAboutToShow();
@@ -215,9 +222,12 @@ private:
     void restoreTraceTypes();
     void restoreTraceSettings();
     void updateViewsOnChange(int);
-    /// open @p file, might be compressed
-    /// @return true when the file could be opened, false otherwise.
-    bool openDataFile(const QString& file);
+    /// open @p file, might be compressed, in the background.
+    /// With @p showError, failing to load is reported in a message box.
+    void openDataFile(const QString& file, bool showError = false);
+    /// run @p thread, replacing a load still in progress
+    void startLoad(LoadThread* thread, bool showError);
+    void loadThreadFinished(LoadThread* thread, bool showError);
 
     QStatusBar* _statusbar;
     QLabel* _statusLabel;
@@ -239,7 +249,7 @@ private:
     KToggleAction *_partDockShown, *_stackDockShown;
     KToggleAction *_functionDockShown, *_dumpDockShown;
     KToggleAction *_taPercentage, *_taExpanded, *_taCycles, *_taHideTemplates;
-    KToggleAction *_taDump, *_taSplit, *_taSplitDir;
+    KToggleAction *_taDump, *_taSplit, *_taSplitDir, *_taFollow;
     KToolBarPopupAction *_paForward, *_paBack, *_paUp;
 
     TraceFunction* _function;
@@ -274,6 +284,10 @@ private:
     QString _progressMsg;
     QElapsedTimer _progressStart;
     QProgressBar* _progressBar;
+    QPushButton* _cancelButton;
+
+    // loading in the background, data is set when finished
+    LoadThread* _loadThread;
 
     // toplevel configuration options
     bool _showPercentage, _showExpanded, _showCycles, _hideTemplates;
@@ -281,6 +295,9 @@ private:
     // for running callgrind_control in the background
     QProcess* _ccProcess;
     QString _ccOutput;
+
+    // polling for parts appended to loaded files
+    QTimer* _followTimer;
 };
 
 #endif
@@ -9,6 +9,7 @@
 #ifndef ADDR_H
 #define ADDR_H
 
+#include <QHash>
 #include <QString>
 
 #include "utils.h"
@@ -30,6 +31,7 @@ public:
     int set(const char *s);
     bool set(FixString& s);
     QString toString() const;
+    uint64 value() const { return _v; }
     // similar to toString(), but adds a space every 4 digits
     QString pretty() const;
 
@@ -53,4 +55,9 @@ private:
     uint64 _v;
 };
 
+inline size_t qHash(const Addr& a, size_t seed = 0)
+{
+    return qHash(a.value(), seed);
+}
+
 #endif // ADDR_H
@@ -8,18 +8,117 @@
 
 #include "loader.h"
 
+#include <string.h>
+
 #include <QIODevice>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QHash>
 #include <QVector>
 #include <QDebug>
+#include <QThread>
+#include <QThreadPool>
+#include <QAtomicInt>
 
 #include "addr.h"
 #include "tracedata.h"
 #include "utils.h"
 #include "fixcost.h"
+#include "globalconfig.h"
+#include "logger.h"
 
 
 #define TRACE_LOADER 0
 
+// files at least this large are parsed in chunks, using multiple threads
+#define CHUNKED_LOAD_MINSIZE (64*1024*1024)
+// chunks should not get smaller than this
+#define CHUNKED_LOAD_MINCHUNK (8*1024*1024)
+
+
+/*
+ * For loading a file in chunks, a pre-scan collects all definitions
+ * of compressed names, and the state needed to start parsing at
+ * the beginning of each chunk.
+ */
+struct CachegrindFunctionName
+{
+    QString name, file, object;
+};
+
+struct CachegrindNames
+{
+    QVector<QString> objects, files;
+    QVector<CachegrindFunctionName> functions;
+};
+
+struct CachegrindChunk
+{
+    qint64 start, end;
+    // number of lines before chunk start
+    int lineNo;
+    // current ELF object and file of functions (null if not set)
+    QString object, file;
+};
+
+/*
+ * For loading summary costs first, the lines of each function are
+ * remembered as blocks, together with the parser state needed to
+ * parse them again for detailed costs (see CachegrindDetail).
+ */
+struct CachegrindBlock
+{
+    qint64 start, end;
+    // number of lines before block start
+    int lineNo;
+    // current ELF object and files at block start (null if not set)
+    QString object, file, functionFile;
+    PositionSpec pos;
+    bool hasLineInfo, hasAddrInfo;
+};
+
+// costs of a call summed up in the current block
+struct CachegrindBlockCall
+{
+    CachegrindBlockCall() { source = nullptr; count = 0; }
+
+    TraceFunctionSource* source;
+    SubCost callCount;
+    QVector<SubCost> cost;
+    int count;
+};
+
+/*
+ * Pending detail of a part loaded with summary costs. On request,
+ * the blocks of a part function are parsed again from the file,
+ * which must not have changed in the meantime.
+ */
+class CachegrindDetail: public DetailSource
+{
+public:
+    explicit CachegrindDetail(const QString& filename);
+
+    bool pending(TracePartFunction* pf) const override
+    { return _blocks.contains(pf); }
+    bool load(TracePartFunction* pf) override;
+    void take(DetailSource* other,
+              TracePartFunction* from, TracePartFunction* to) override;
+
+    bool isEmpty() const { return _blocks.isEmpty(); }
+    void addBlock(TracePartFunction* pf, const CachegrindBlock& b)
+    { _blocks[pf].append(b); }
+    // definitions of compressed names used in the part
+    void setNames(const CachegrindNames& names) { _names = names; }
+
+private:
+    QString _filename;
+    qint64 _size;
+    QDateTime _lastModified;
+    CachegrindNames _names;
+    QHash<TracePartFunction*, QVector<CachegrindBlock> > _blocks;
+};
+
 /*
  * Loader for Callgrind Profile data (format based on Cachegrind format).
  * See Callgrind documentation for the file format.
@@ -29,15 +128,36 @@ class CachegrindLoader: public Loader
 {
 public:
     CachegrindLoader();
+    ~CachegrindLoader() override;
 
     bool canLoad(QIODevice* file) override;
-    int  load(TraceData*, QIODevice* file, const QString& filename) override;
+    int  load(TraceData*, QIODevice* file, const QString& filename,
+              Logger* logger = nullptr) override;
+    int  loadAppended(TraceData*, QIODevice* file, const QString& filename,
+                      LoaderPosition& pos, Logger* logger = nullptr) override;
+
+    // parse @p blocks of @p pf again, see CachegrindDetail
+    bool loadDetail(TracePartFunction* pf, FixFile& file,
+                    const QVector<CachegrindBlock>& blocks,
+                    const CachegrindNames* names);
 
 private:
     void error(QString);
     void warning(QString);
 
-    int loadInternal(TraceData*, QIODevice* file, const QString& filename);
+    int loadInternal(TraceData*, QIODevice* file, const QString& filename,
+                     LoaderPosition* pos = nullptr);
+    qint64 appendedEnd(FixFile& file, qint64 from);
+    bool parseLines(FixFile& file);
+
+    // parallel parsing of a single-part file
+    int loadChunked(FixFile& file, int threads);
+    bool scanChunks(FixFile& file, int count, qint64& headerEnd,
+                    QList<CachegrindChunk>& chunks, CachegrindNames& names);
+    int scanCompressed(FixString& s, QString& name);
+    bool loadChunk(TraceData*, FixFile& file, qint64 headerEnd,
+                   const CachegrindChunk& chunk, const CachegrindNames* names,
+                   bool reportHeader);
 
     enum lineType { SelfCost, CallCost, BoringJump, CondJump };
 
@@ -48,12 +168,12 @@ private:
     void ensureObject();
     void ensureFile();
     void ensureFunction();
-    void setObject(const QString&);
-    void setCalledObject(const QString&);
-    void setFile(const QString&);
-    void setCalledFile(const QString&);
-    void setFunction(const QString&);
-    void setCalledFunction(const QString&);
+    void setObject(FixString&);
+    void setCalledObject(FixString&);
+    void setFile(FixString&);
+    void setCalledFile(FixString&);
+    void setFunction(FixString&);
+    void setCalledFunction(FixString&);
 
     void prepareNewPart();
 
@@ -115,12 +235,39 @@ private:
    */
     void clearCompression();
     const QString& checkUnknown(const QString& n);
-    TraceObject* compressedObject(const QString& name);
-    TraceFile* compressedFile(const QString& name);
-    TraceFunction* compressedFunction(const QString& name,
+    int splitCompressed(FixString s, FixString& name);
+    // ID of name in the name pool of the data, "???" being empty
+    int nameId(FixString& name);
+    TraceObject* compressedObject(FixString& name);
+    TraceFile* compressedFile(FixString& name);
+    TraceFunction* compressedFunction(FixString& name,
                                       TraceFile*, TraceObject*);
 
     QVector<TraceCostItem*> _objectVector, _fileVector, _functionVector;
+
+    // definitions from a pre-scan, used for references not yet defined
+    const CachegrindNames* _names;
+    TraceObject* scannedObject(int index);
+    TraceFile* scannedFile(int index);
+    TraceFunction* scannedFunction(int index);
+
+    /* Summary loading: instead of fix cost items for every line,
+     * costs of a function block are summed up, and the block is
+     * remembered in _detail to get the detailed costs when needed.
+     */
+    void startBlock(qint64 offset);
+    void endBlock(qint64 offset);
+    void addBlockCost(FixString& line);
+    void addBlockCallCost(TracePartCall* partCall, FixString& line);
+    void finishDetail();
+
+    CachegrindDetail* _detail;
+    CachegrindBlock _block;
+    TracePartFunction* _blockFunction;
+    TraceFunctionSource* _blockSource;
+    QVector<SubCost> _blockCost;
+    int _blockCostCount;
+    QHash<TracePartCall*, CachegrindBlockCall> _blockCalls;
 };
 
 
@@ -134,6 +281,16 @@ CachegrindLoader::CachegrindLoader()
     : Loader(QStringLiteral("Callgrind"),
              QObject::tr( "Import filter for Cachegrind/Callgrind generated profile data files") )
 {
+    _names = nullptr;
+    _detail = nullptr;
+    _blockFunction = nullptr;
+    _blockSource = nullptr;
+    _blockCostCount = 0;
+}
+
+CachegrindLoader::~CachegrindLoader()
+{
+    delete _detail;
 }
 
 bool CachegrindLoader::canLoad(QIODevice* file)
@@ -171,18 +328,118 @@ bool CachegrindLoader::canLoad(QIODevice* file)
 }
 
 int CachegrindLoader::load(TraceData* d,
-                           QIODevice* file, const QString& filename)
+                           QIODevice* file, const QString& filename,
+                           Logger* logger)
 {
     /* do the loading in a new object so parallel load
    * operations do not interfere each other.
    */
     CachegrindLoader l;
 
-    l.setLogger(_logger);
+    l.setLogger(logger ? logger : _logger);
 
     return l.loadInternal(d, file, filename);
 }
 
+int CachegrindLoader::loadAppended(TraceData* d,
+                                   QIODevice* file, const QString& filename,
+                                   LoaderPosition& pos, Logger* logger)
+{
+    CachegrindLoader l;
+
+    l.setLogger(logger ? logger : _logger);
+
+    return l.loadInternal(d, file, filename, &pos);
+}
+
+/**
+ * Replace the summary costs of @p pf by fix cost items for each cost
+ * line found in @p blocks, reusing the compressed names @p names.
+ */
+bool CachegrindLoader::loadDetail(TracePartFunction* pf, FixFile& file,
+                                  const QVector<CachegrindBlock>& blocks,
+                                  const CachegrindNames* names)
+{
+    _part = pf->part();
+    _data = _part->data();
+    _filename = _part->name();
+    _names = names;
+    partsAdded = 0;
+    clearCompression();
+
+    pf->setFirstFixCost(nullptr);
+    foreach(TracePartCall* pc, pf->partCallings())
+        pc->setFirstFixCallCost(nullptr);
+
+    foreach(const CachegrindBlock& b, blocks) {
+        clearPosition();
+        mapping = _part->eventTypeMapping();
+
+        if (!b.object.isNull()) {
+            currentObject = _data->object(b.object);
+            currentPartObject = currentObject->partObject(_part);
+        }
+        if (!b.file.isNull()) {
+            currentFile = _data->file(b.file);
+            currentPartFile = currentFile->partFile(_part);
+        }
+        if (!b.functionFile.isNull())
+            currentFunctionFile = _data->file(b.functionFile);
+        currentFunction = pf->function();
+        currentPartFunction = pf;
+        currentPos = b.pos;
+
+        nextLineType = SelfCost;
+        hasLineInfo = b.hasLineInfo;
+        hasAddrInfo = b.hasAddrInfo;
+
+        _lineNo = b.lineNo;
+        FixFile range(file, b.start, b.end);
+        if (!parseLines(range)) return false;
+    }
+    _names = nullptr;
+
+    return true;
+}
+
+
+CachegrindDetail::CachegrindDetail(const QString& filename)
+{
+    QFileInfo info(filename);
+
+    _filename = filename;
+    _size = info.size();
+    _lastModified = info.lastModified();
+}
+
+bool CachegrindDetail::load(TracePartFunction* pf)
+{
+    if (!_blocks.contains(pf)) return true;
+    // only tried once
+    QVector<CachegrindBlock> blocks = _blocks.take(pf);
+
+    QFileInfo info(_filename);
+    if ((info.size() != _size) || (info.lastModified() != _lastModified))
+        return false;
+
+    QFile device(_filename);
+    FixFile file(&device, _filename);
+    if (!file.exists() || file.isStreamed()) return false;
+
+    CachegrindLoader l;
+    return l.loadDetail(pf, file, blocks, &_names);
+}
+
+void CachegrindDetail::take(DetailSource* other,
+                            TracePartFunction* from, TracePartFunction* to)
+{
+    CachegrindDetail* d = dynamic_cast<CachegrindDetail*>(other);
+    if (!d || !d->_blocks.contains(from)) return;
+
+    QVector<CachegrindBlock> blocks = d->_blocks.take(from);
+    _blocks[to] += blocks;
+}
+
 Loader* createCachegrindLoader()
 {
     return new CachegrindLoader();
@@ -344,21 +601,48 @@ const QString& CachegrindLoader::checkUnknown(const QString& n)
     return n;
 }
 
-TraceObject* CachegrindLoader::compressedObject(const QString& name)
+/* Split compressed name "(<index>) <name>" in @p s into the index,
+ * which is returned, and @p name, empty for a compression reference.
+ * Returns -1 if @p s is a regular name, -2 for an invalid index.
+ */
+int CachegrindLoader::splitCompressed(FixString s, FixString& name)
 {
-    if ((name[0] != '(') || !name[1].isDigit()) return _data->object(checkUnknown(name));
+    uint index;
+    char c;
+
+    if (!s.stripFirst(c) || (c != '(') ||
+        !s.first(c) || (c < '0') || (c > '9'))
+        return -1;
+    if (!s.stripUInt(index, false) || !s.stripPrefix(")"))
+        return -2;
+    s.stripSpaces();
+    name = s;
+
+    return (int) index;
+}
+
+int CachegrindLoader::nameId(FixString& name)
+{
+    NamePool* pool = _data->namePool();
+
+    if ((name.len() == 3) && (strncmp(name.ascii(), "???", 3) == 0))
+        return pool->id("", 0);
+    return pool->id(name.ascii(), name.len());
+}
+
+TraceObject* CachegrindLoader::compressedObject(FixString& name)
+{
+    FixString realName;
+    int index = splitCompressed(name, realName);
+    if (index == -1) return _data->objectById(nameId(name));
 
     // compressed format using _objectVector
-    int p = name.indexOf(')');
-    if (p<2) {
-        error(QStringLiteral("Invalid compressed ELF object ('%1')").arg(name));
+    if (index < 0) {
+        error(QStringLiteral("Invalid compressed ELF object ('%1')").arg(QString(name)));
         return nullptr;
     }
-    int index = name.mid(1, p-1).toInt();
     TraceObject* o = nullptr;
-    p++;
-    while((name.length()>p) && name.at(p).isSpace()) p++;
-    if (name.length()>p) {
+    if (!realName.isEmpty()) {
         if (_objectVector.size() <= index) {
             int newSize = index * 2;
 #if TRACE_LOADER
@@ -368,21 +652,24 @@ TraceObject* CachegrindLoader::compressedObject(const QString& name)
             _objectVector.resize(newSize);
         }
 
-        QString realName = checkUnknown(name.mid(p));
+        TraceObject* newObject = _data->objectById(nameId(realName));
         o = (TraceObject*) _objectVector.at(index);
-        if (o && (o->name() != realName)) {
+        if (o && (o != newObject)) {
             error(QStringLiteral("Redefinition of compressed ELF object index %1 (was '%2') to %3")
-                  .arg(index).arg(o->name()).arg(realName));
+                  .arg(index).arg(o->name()).arg(newObject->name()));
         }
 
-        o = _data->object(realName);
+        o = newObject;
         _objectVector.replace(index, o);
     }
     else {
         if ((_objectVector.size() <= index) ||
             ( (o=(TraceObject*)_objectVector.at(index)) == nullptr)) {
-            error(QStringLiteral("Undefined compressed ELF object index %1").arg(index));
-            return nullptr;
+            o = scannedObject(index);
+            if (!o) {
+                error(QStringLiteral("Undefined compressed ELF object index %1").arg(index));
+                return nullptr;
+            }
         }
     }
 
@@ -392,21 +679,19 @@ TraceObject* CachegrindLoader::compressedObject(const QString& name)
 
 // Note: Callgrind sometimes gives different IDs for same file
 // (when references to same source file come from different ELF objects)
-TraceFile* CachegrindLoader::compressedFile(const QString& name)
+TraceFile* CachegrindLoader::compressedFile(FixString& name)
 {
-    if ((name[0] != '(') || !name[1].isDigit()) return _data->file(checkUnknown(name));
+    FixString realName;
+    int index = splitCompressed(name, realName);
+    if (index == -1) return _data->fileById(nameId(name));
 
     // compressed format using _fileVector
-    int p = name.indexOf(')');
-    if (p<2) {
-        error(QStringLiteral("Invalid compressed file ('%1')").arg(name));
+    if (index < 0) {
+        error(QStringLiteral("Invalid compressed file ('%1')").arg(QString(name)));
         return nullptr;
     }
-    int index = name.mid(1, p-1).toUInt();
     TraceFile* f = nullptr;
-    p++;
-    while((name.length()>p) && name.at(p).isSpace()) p++;
-    if (name.length()>p) {
+    if (!realName.isEmpty()) {
         if (_fileVector.size() <= index) {
             int newSize = index * 2;
 #if TRACE_LOADER
@@ -416,21 +701,24 @@ TraceFile* CachegrindLoader::compressedFile(const QString& name)
             _fileVector.resize(newSize);
         }
 
-        QString realName = checkUnknown(name.mid(p));
+        TraceFile* newFile = _data->fileById(nameId(realName));
         f = (TraceFile*) _fileVector.at(index);
-        if (f && (f->name() != realName)) {
+        if (f && (f != newFile)) {
             error(QStringLiteral("Redefinition of compressed file index %1 (was '%2') to %3")
-                  .arg(index).arg(f->name()).arg(realName));
+                  .arg(index).arg(f->name()).arg(newFile->name()));
         }
 
-        f = _data->file(realName);
+        f = newFile;
         _fileVector.replace(index, f);
     }
     else {
         if ((_fileVector.size() <= index) ||
             ( (f=(TraceFile*)_fileVector.at(index)) == nullptr)) {
-            error(QStringLiteral("Undefined compressed file index %1").arg(index));
-            return nullptr;
+            f = scannedFile(index);
+            if (!f) {
+                error(QStringLiteral("Undefined compressed file index %1").arg(index));
+                return nullptr;
+            }
         }
     }
 
@@ -440,26 +728,23 @@ TraceFile* CachegrindLoader::compressedFile(const QString& name)
 // Note: Callgrind gives different IDs even for same function
 // when parts of the function are from different source files.
 // Thus, it is no error when multiple indexes map to same function.
-TraceFunction* CachegrindLoader::compressedFunction(const QString& name,
+TraceFunction* CachegrindLoader::compressedFunction(FixString& name,
                                                     TraceFile* file,
                                                     TraceObject* object)
 {
-    if ((name[0] != '(') || !name[1].isDigit())
-        return _data->function(checkUnknown(name), file, object);
+    FixString realName;
+    int index = splitCompressed(name, realName);
+    if (index == -1)
+        return _data->functionById(nameId(name), file, object);
 
     // compressed format using _functionVector
-    int p = name.indexOf(')');
-    if (p<2) {
-        error(QStringLiteral("Invalid compressed function ('%1')").arg(name));
+    if (index < 0) {
+        error(QStringLiteral("Invalid compressed function ('%1')").arg(QString(name)));
         return nullptr;
     }
 
-
-    int index = name.mid(1, p-1).toUInt();
     TraceFunction* f = nullptr;
-    p++;
-    while((name.length()>p) && name.at(p).isSpace()) p++;
-    if (name.length()>p) {
+    if (!realName.isEmpty()) {
         if (_functionVector.size() <= index) {
             int newSize = index * 2;
 #if TRACE_LOADER
@@ -469,14 +754,15 @@ TraceFunction* CachegrindLoader::compressedFunction(const QString& name,
             _functionVector.resize(newSize);
         }
 
-        QString realName = checkUnknown(name.mid(p));
+        TraceFunction* newFunction = _data->functionById(nameId(realName),
+                                                         file, object);
         f = (TraceFunction*) _functionVector.at(index);
-        if (f && (f->name() != realName)) {
+        if (f && newFunction && (f->name() != newFunction->name())) {
             error(QStringLiteral("Redefinition of compressed function index %1 (was '%2') to %3")
-                  .arg(index).arg(f->name()).arg(realName));
+                  .arg(index).arg(f->name()).arg(newFunction->name()));
         }
 
-        f = _data->function(realName, file, object);
+        f = newFunction;
         _functionVector.replace(index, f);
 
 #if TRACE_LOADER
@@ -490,8 +776,11 @@ TraceFunction* CachegrindLoader::compressedFunction(const QString& name,
     else {
         if ((_functionVector.size() <= index) ||
             ( (f=(TraceFunction*)_functionVector.at(index)) == nullptr)) {
-            error(QStringLiteral("Undefined compressed function index %1").arg(index));
-            return nullptr;
+            f = scannedFunction(index);
+            if (!f) {
+                error(QStringLiteral("Undefined compressed function index %1").arg(index));
+                return nullptr;
+            }
         }
 
         // there was a check if the used function (returned from KCachegrinds
@@ -504,6 +793,51 @@ TraceFunction* CachegrindLoader::compressedFunction(const QString& name,
 }
 
 
+// Definitions found by pre-scan when loading in chunks.
+// Items get created on first use, and stored for further references.
+TraceObject* CachegrindLoader::scannedObject(int index)
+{
+    if (!_names || (index >= _names->objects.size()) ||
+        _names->objects.at(index).isNull())
+        return nullptr;
+
+    TraceObject* o = _data->object(checkUnknown(_names->objects.at(index)));
+    if (_objectVector.size() <= index)
+        _objectVector.resize(index * 2);
+    _objectVector.replace(index, o);
+    return o;
+}
+
+TraceFile* CachegrindLoader::scannedFile(int index)
+{
+    if (!_names || (index >= _names->files.size()) ||
+        _names->files.at(index).isNull())
+        return nullptr;
+
+    TraceFile* f = _data->file(checkUnknown(_names->files.at(index)));
+    if (_fileVector.size() <= index)
+        _fileVector.resize(index * 2);
+    _fileVector.replace(index, f);
+    return f;
+}
+
+TraceFunction* CachegrindLoader::scannedFunction(int index)
+{
+    if (!_names || (index >= _names->functions.size()) ||
+        _names->functions.at(index).name.isNull())
+        return nullptr;
+
+    const CachegrindFunctionName& n = _names->functions.at(index);
+    TraceFunction* f = _data->function(checkUnknown(n.name),
+                                       _data->file(n.file),
+                                       _data->object(n.object));
+    if (_functionVector.size() <= index)
+        _functionVector.resize(index * 2);
+    _functionVector.replace(index, f);
+    return f;
+}
+
+
 // make sure that a valid object is set, at least dummy with empty name
 void CachegrindLoader::ensureObject()
 {
@@ -513,7 +847,7 @@ void CachegrindLoader::ensureObject()
     currentPartObject = currentObject->partObject(_part);
 }
 
-void CachegrindLoader::setObject(const QString& name)
+void CachegrindLoader::setObject(FixString& name)
 {
     currentObject = compressedObject(name);
     if (!currentObject) {
@@ -527,7 +861,7 @@ void CachegrindLoader::setObject(const QString& name)
     currentPartFunction = nullptr;
 }
 
-void CachegrindLoader::setCalledObject(const QString& name)
+void CachegrindLoader::setCalledObject(FixString& name)
 {
     currentCalledObject = compressedObject(name);
 
@@ -550,7 +884,7 @@ void CachegrindLoader::ensureFile()
     currentPartFile = currentFile->partFile(_part);
 }
 
-void CachegrindLoader::setFile(const QString& name)
+void CachegrindLoader::setFile(FixString& name)
 {
     currentFile = compressedFile(name);
 
@@ -565,7 +899,7 @@ void CachegrindLoader::setFile(const QString& name)
     currentPartLine = nullptr;
 }
 
-void CachegrindLoader::setCalledFile(const QString& name)
+void CachegrindLoader::setCalledFile(FixString& name)
 {
     currentCalledFile = compressedFile(name);
 
@@ -596,7 +930,7 @@ void CachegrindLoader::ensureFunction()
                                                         currentPartObject);
 }
 
-void CachegrindLoader::setFunction(const QString& name)
+void CachegrindLoader::setFunction(FixString& name)
 {
     ensureFile();
     ensureObject();
@@ -622,7 +956,7 @@ void CachegrindLoader::setFunction(const QString& name)
     currentPartLine = nullptr;
 }
 
-void CachegrindLoader::setCalledFunction(const QString& name)
+void CachegrindLoader::setCalledFunction(FixString& name)
 {
     // if called object/file not set, use current object/file
     if (!currentCalledObject) {
@@ -701,6 +1035,7 @@ void CachegrindLoader::prepareNewPart()
         _part->invalidate();
         _part->totals()->clear();
         _part->totals()->addCost(_part);
+        finishDetail();
         _data->addPart(_part);
         partsAdded++;
     }
@@ -712,11 +1047,56 @@ void CachegrindLoader::prepareNewPart()
     _part->setName(_filename);
 }
 
+/**
+ * End of the last complete part after offset @p from, or -1.
+ *
+ * Callgrind appends parts to files while running (e.g. with
+ * "--dump-every-bb" or on "callgrind_control -d"), and ends each
+ * part with a "totals:" line. Other files are loaded completely.
+ */
+qint64 CachegrindLoader::appendedEnd(FixFile& file, qint64 from)
+{
+    // compressed data cannot be continued
+    if (file.isStreamed())
+        return (from == 0) ? file.len() : -1;
+
+    FixString line;
+    bool isCallgrind = false;
+    file.rewind();
+    for (int i = 0; (i < 100) && file.nextLine(line); i++) {
+        if (line.stripPrefix("# callgrind format") ||
+            (line.stripPrefix("creator:") && QString(line).contains(QLatin1String("callgrind")))) {
+            isCallgrind = true;
+            break;
+        }
+        if (line.stripPrefix("events:")) break;
+    }
+    if (!isCallgrind)
+        return (from == 0) ? file.len() : -1;
+
+    qint64 end = -1;
+    file.setCurrent(from);
+    while(1) {
+        qint64 start = file.current();
+        if (!file.nextLine(line)) break;
+        int len = line.len();
+        if (!line.stripPrefix("totals:")) continue;
+        // a line still being written has no line end yet
+        if (file.current() > start + len) end = file.current();
+    }
+    file.rewind();
+    return end;
+}
+
 /**
  * The main import function...
+ *
+ * With @p pos given, only complete parts after the position are loaded,
+ * and the position is updated (see Loader::loadAppended).
  */
 int CachegrindLoader::loadInternal(TraceData* data,
-                                   QIODevice* device, const QString& filename)
+                                   QIODevice* device, const QString& filename,
+                                   LoaderPosition* pos)
 {
     if (!data || !device) return 0;
 
@@ -724,36 +1104,117 @@ int CachegrindLoader::loadInternal(TraceData* data,
     _filename = filename;
     _lineNo = 0;
 
+    FixFile file(device, _filename);
+
+    // with nothing appended, there is no notification at all
+    qint64 end = -1;
+    if (pos && file.exists()) {
+        end = appendedEnd(file, pos->offset);
+        if (end <= pos->offset) {
+            device->close();
+            return 0;
+        }
+        _lineNo = pos->lineNo;
+    }
+
     loadStart(_filename);
 
-    FixFile file(device, _filename);
     if (!file.exists()) {
         loadFinished(QStringLiteral("File does not exist"));
         return 0;
     }
 
-    int statusProgress = 0;
-
 #if USE_FIXCOST
-    // FixCost Memory Pool
-    FixPool* pool = _data->fixPool();
+    // detail is parsed again from the file later: needs random access
+    if (!pos && GlobalConfig::loadDetailOnDemand() &&
+        !file.isStreamed() && dynamic_cast<QFile*>(device))
+        _detail = new CachegrindDetail(_filename);
+
+    int threads = _data->loadThreads();
+    // streamed (compressed) data cannot be split into chunks
+    if (!pos && (threads > 1) && !file.isStreamed() &&
+        (file.len() >= CHUNKED_LOAD_MINSIZE)) {
+        int parts = loadChunked(file, threads);
+        // negative if chunked parsing is not possible for this file
+        if (parts >= 0) {
+            loadFinished();
+            device->close();
+            return parts;
+        }
+    }
 #endif
 
     _part = nullptr;
     partsAdded = 0;
     prepareNewPart();
 
-    FixString line;
-    char c;
-
     // current position
     nextLineType  = SelfCost;
     // default if there is no "positions:" line
     hasLineInfo = true;
     hasAddrInfo = false;
 
+    if (pos && !file.isStreamed()) {
+        FixFile appended(file, pos->offset, end);
+        if (!parseLines(appended)) return 0;
+    }
+    else {
+        if (!parseLines(file)) return 0;
+    }
+    if (pos) {
+        pos->offset = end;
+        pos->lineNo = _lineNo;
+    }
+
+    loadFinished();
+
+    if (mapping) {
+        _part->invalidate();
+        _part->totals()->clear();
+        _part->totals()->addCost(_part);
+        finishDetail();
+        data->addPart(_part);
+        partsAdded++;
+    }
+    else {
+        error(QStringLiteral("No data found. Skipping file"));
+        delete _part;
+    }
+
+    device->close();
+
+    return partsAdded;
+}
+
+/**
+ * Parse the lines of @p file, starting with the current state.
+ * Returns false on a fatal format error, with the current part deleted.
+ */
+bool CachegrindLoader::parseLines(FixFile& file)
+{
+    int statusProgress = 0;
+
+#if USE_FIXCOST
+    // FixCost Memory Pool
+    FixPool* pool = _data->fixPool();
+#endif
+
+    FixString line;
+    char c;
+    // start of the current line, relative to file.start()
+    qint64 lineStart, lineEnd = file.current();
+
     while (file.nextLine(line)) {
 
+        lineStart = lineEnd;
+        lineEnd = file.current();
+
+        // a load canceled from another thread leaves no part behind
+        if (((_lineNo & 0xfff) == 0) && _data->loadCanceled()) {
+            delete _part;
+            return false;
+        }
+
         _lineNo++;
 
 #if TRACE_LOADER
@@ -780,6 +1241,11 @@ int CachegrindLoader::loadInternal(TraceData* data,
 
             line.stripFirst(c);
 
+            // lines not describing function data end a function block
+            if (_blockFunction && (c != 'f') && (c != 'c') && (c != 'j') &&
+                (c != 'o') && (c != 'r'))
+                endBlock(file.start() + lineStart);
+
             /* in order of probability */
             switch(c) {
 
@@ -805,9 +1271,12 @@ int CachegrindLoader::loadInternal(TraceData* data,
                 // fn=
                 if (line.stripPrefix("n=")) {
 
+                    if (_detail) startBlock(file.start() + lineStart);
+
                     if (currentFile != currentFunctionFile)
                         currentFile = currentFunctionFile;
                     setFunction(line);
+                    if (_detail) _blockFunction = currentPartFunction;
 
                     // on a new function, update status
                     int progress = (int)(100.0 * file.current() / file.len() +.5);
@@ -858,6 +1327,7 @@ int CachegrindLoader::loadInternal(TraceData* data,
 
                 // cmd:
                 if (line.stripPrefix("md:")) {
+                    endBlock(file.start() + lineStart);
                     QString command = QString(line).trimmed();
                     if (!_data->command().isEmpty() &&
                         _data->command() != command) {
@@ -870,6 +1340,7 @@ int CachegrindLoader::loadInternal(TraceData* data,
 
                 // creator:
                 if (line.stripPrefix("reator:")) {
+                    endBlock(file.start() + lineStart);
                     // ignore ...
                     continue;
                 }
@@ -999,7 +1470,13 @@ int CachegrindLoader::loadInternal(TraceData* data,
                 // events:
                 if (line.stripPrefix("vents:")) {
                     prepareNewPart();
-                    mapping = _data->eventTypes()->createMapping(line);
+                    QStringList selection = GlobalConfig::loadEvents();
+                    mapping = _data->eventTypes()->createMapping(line, selection);
+                    if ((mapping->count() == 0) && !selection.isEmpty()) {
+                        warning(QStringLiteral("None of the selected events found, loading all"));
+                        delete mapping;
+                        mapping = _data->eventTypes()->createMapping(line);
+                    }
                     _part->setEventMapping(mapping);
                     continue;
                 }
@@ -1115,6 +1592,12 @@ int CachegrindLoader::loadInternal(TraceData* data,
                                                                 true);
         }
 
+        // summary loading: cost of another function starts a new block
+        if (_detail && (currentPartFunction != _blockFunction)) {
+            startBlock(file.start() + lineStart);
+            _blockFunction = currentPartFunction;
+        }
+
 #if !USE_FIXCOST
         if (hasAddrInfo) {
             if (!currentInstr ||
@@ -1165,11 +1648,14 @@ int CachegrindLoader::loadInternal(TraceData* data,
         if (nextLineType == SelfCost) {
 
 #if USE_FIXCOST
-            new (pool) FixCost(_part, pool,
-                               currentFunctionSource,
-                               currentPos,
-                               currentPartFunction,
-                               line);
+            if (_detail)
+                addBlockCost(line);
+            else
+                new (pool) FixCost(_part, pool,
+                                   currentFunctionSource,
+                                   currentPos,
+                                   currentPartFunction,
+                                   line);
 #else
             if (hasAddrInfo) {
                 TracePartInstr* partInstr;
@@ -1207,15 +1693,19 @@ int CachegrindLoader::loadInternal(TraceData* data,
                                       currentCalledPartFunction);
 
 #if USE_FIXCOST
-            FixCallCost* fcc;
-            fcc = new (pool) FixCallCost(_part, pool,
-                                         currentFunctionSource,
-                                         hasLineInfo ? currentPos.fromLine : 0,
-                                         hasAddrInfo ? currentPos.fromAddr : Addr(0),
-                                         partCalling,
-                                         currentCallCount, line);
-            fcc->setMax(_data->callMax());
-            _data->updateMaxCallCount(fcc->callCount());
+            if (_detail)
+                addBlockCallCost(partCalling, line);
+            else {
+                FixCallCost* fcc;
+                fcc = new (pool) FixCallCost(_part, pool,
+                                             currentFunctionSource,
+                                             hasLineInfo ? currentPos.fromLine : 0,
+                                             hasAddrInfo ? currentPos.fromAddr : Addr(0),
+                                             partCalling,
+                                             currentCallCount, line);
+                fcc->setMax(_data->callMax());
+                _data->updateMaxCallCount(fcc->callCount());
+            }
 #else
             if (hasAddrInfo) {
                 TraceInstrCall* instrCall;
@@ -1278,19 +1768,21 @@ int CachegrindLoader::loadInternal(TraceData* data,
                                currentFunctionSource;
 
 #if USE_FIXCOST
-            new (pool) FixJump(_part, pool,
-                               /* source */
-                               hasLineInfo ? currentPos.fromLine : 0,
-                               hasAddrInfo ? currentPos.fromAddr : 0,
-                               currentPartFunction,
-                               currentFunctionSource,
-                               /* target */
-                               hasLineInfo ? targetPos.fromLine : 0,
-                               hasAddrInfo ? targetPos.fromAddr : Addr(0),
-                               currentJumpToFunction,
-                               targetSource,
-                               (nextLineType == CondJump),
-                               jumpsExecuted, jumpsFollowed);
+            // jumps are detail only
+            if (!_detail)
+                new (pool) FixJump(_part, pool,
+                                   /* source */
+                                   hasLineInfo ? currentPos.fromLine : 0,
+                                   hasAddrInfo ? currentPos.fromAddr : 0,
+                                   currentPartFunction,
+                                   currentFunctionSource,
+                                   /* target */
+                                   hasLineInfo ? targetPos.fromLine : 0,
+                                   hasAddrInfo ? targetPos.fromAddr : Addr(0),
+                                   currentJumpToFunction,
+                                   targetSource,
+                                   (nextLineType == CondJump),
+                                   jumpsExecuted, jumpsFollowed);
 #else
             if (hasAddrInfo) {
                 TraceInstr* jumpToInstr;
@@ -1348,22 +1840,541 @@ int CachegrindLoader::loadInternal(TraceData* data,
         }
     }
 
-    loadFinished();
+    endBlock(file.start() + file.current());
 
-    if (mapping) {
-        _part->invalidate();
-        _part->totals()->clear();
-        _part->totals()->addCost(_part);
-        data->addPart(_part);
-        partsAdded++;
+    return true;
+}
+
+
+/*
+ * Summary loading
+ */
+
+// add costs given in @p s to @p cost, returns number of costs found
+static int addCosts(EventTypeMapping* m, FixString& s,
+                    SubCost* cost, int maxCount)
+{
+    uint64 v;
+    int i = 0;
+    bool skip = m->hasSkipped();
+
+    s.stripSpaces();
+    while(i<maxCount) {
+        if (skip) m->skipValues(s, i);
+        if (!s.stripUInt64(v)) {
+            // negative costs are clamped to zero, see FixCost
+            int64 temp;
+            if (s.stripInt64(temp) && temp < 0)
+                v = 0;
+            else
+                break;
+        }
+        cost[i++] += v;
+    }
+    return i;
+}
+
+/**
+ * Start a new block of lines for the current function at @p offset,
+ * remembering the parser state at that point.
+ */
+void CachegrindLoader::startBlock(qint64 offset)
+{
+    endBlock(offset);
+
+    _block.start = offset;
+    _block.lineNo = _lineNo - 1;
+    _block.object = currentObject ? currentObject->name() : QString();
+    _block.file = currentFile ? currentFile->name() : QString();
+    _block.functionFile = currentFunctionFile ?
+                              currentFunctionFile->name() : QString();
+    _block.pos = currentPos;
+    _block.hasLineInfo = hasLineInfo;
+    _block.hasAddrInfo = hasAddrInfo;
+
+    _blockSource = nullptr;
+    _blockCost.fill(0, mapping ? mapping->count() : 0);
+    _blockCostCount = 0;
+}
+
+/**
+ * End the current block at @p offset, and add summary fix cost items
+ * for the costs of the block: no position, so lineMap()/instrMap()
+ * skip them (these load the detail before).
+ */
+void CachegrindLoader::endBlock(qint64 offset)
+{
+    if (!_blockFunction) return;
+
+    _block.end = offset;
+    _detail->addBlock(_blockFunction, _block);
+
+    FixPool* pool = _data->fixPool();
+    if (_blockCostCount > 0) {
+        PositionSpec noPosition;
+        new (pool) FixCost(_part, pool, _blockSource, noPosition,
+                           _blockFunction,
+                           _blockCostCount, _blockCost.constData());
+    }
+
+    QHash<TracePartCall*, CachegrindBlockCall>::ConstIterator it;
+    for (it = _blockCalls.constBegin(); it != _blockCalls.constEnd(); ++it) {
+        const CachegrindBlockCall& bc = it.value();
+        FixCallCost* fcc;
+        fcc = new (pool) FixCallCost(_part, pool, bc.source, 0, Addr(0),
+                                     it.key(), bc.callCount,
+                                     bc.count, bc.cost.constData());
+        fcc->setMax(_data->callMax());
+        _data->updateMaxCallCount(fcc->callCount());
+    }
+    _blockCalls.clear();
+
+    _blockFunction = nullptr;
+}
+
+void CachegrindLoader::addBlockCost(FixString& line)
+{
+    if (!_blockSource) _blockSource = currentFunctionSource;
+    if (_blockCost.size() < mapping->count())
+        _blockCost.resize(mapping->count());
+
+    int count = addCosts(mapping, line, _blockCost.data(), _blockCost.size());
+    if (count > _blockCostCount) _blockCostCount = count;
+}
+
+void CachegrindLoader::addBlockCallCost(TracePartCall* partCall,
+                                        FixString& line)
+{
+    CachegrindBlockCall& bc = _blockCalls[partCall];
+    if (!bc.source) {
+        bc.source = currentFunctionSource;
+        bc.cost.fill(0, mapping->count());
     }
+    bc.callCount += currentCallCount;
+
+    int count = addCosts(mapping, line, bc.cost.data(), bc.cost.size());
+    if (count > bc.count) bc.count = count;
+}
+
+/**
+ * Pass pending detail of the current part to the part, with the
+ * definitions of compressed names needed to parse its blocks again.
+ */
+void CachegrindLoader::finishDetail()
+{
+    if (!_detail || _detail->isEmpty()) return;
+
+    if (_names)
+        _detail->setNames(*_names);
     else {
+        // definitions at end of part. Null names are undefined
+        CachegrindNames names;
+        int i;
+        for (i = 0; i < _objectVector.size(); i++) {
+            if (!_objectVector[i]) continue;
+            names.objects.resize(i+1);
+            names.objects[i] = _objectVector[i]->name();
+            if (names.objects[i].isNull())
+                names.objects[i] = QStringLiteral("???");
+        }
+        for (i = 0; i < _fileVector.size(); i++) {
+            if (!_fileVector[i]) continue;
+            names.files.resize(i+1);
+            names.files[i] = _fileVector[i]->name();
+            if (names.files[i].isNull())
+                names.files[i] = QStringLiteral("???");
+        }
+        for (i = 0; i < _functionVector.size(); i++) {
+            TraceFunction* f = (TraceFunction*) _functionVector[i];
+            if (!f) continue;
+            names.functions.resize(i+1);
+            CachegrindFunctionName& n = names.functions[i];
+            n.name = f->name().isNull() ? QStringLiteral("???") : f->name();
+            n.file = f->file()->name();
+            n.object = f->object()->name();
+        }
+        _detail->setNames(names);
+    }
+
+    _part->setDetailSource(_detail);
+    _detail = new CachegrindDetail(_filename);
+}
+
+
+/*
+ * Parallel parsing of a single-part file
+ *
+ * Chunks start at "fn=" lines which are followed by an absolute
+ * position. At such a line, the parser only depends on the current
+ * ELF object and file, and on definitions of compressed names.
+ * Both are collected by a pre-scan which only looks at lines
+ * specifying names. Each chunk is parsed into its own TraceData by
+ * a separate loader, which first parses the file header, and these
+ * are fused into one part afterwards.
+ */
+
+// does a position line not depend on the previous position?
+static bool isAbsolutePosition(FixString s, bool hasAddrInfo, bool hasLineInfo)
+{
+    char c;
+    int count = (hasAddrInfo ? 1:0) + (hasLineInfo ? 1:0);
+
+    for (int i = 0; i < count; i++) {
+        if (!s.first(c) || (c < '0') || (c > '9')) return false;
+        s.stripUntil(' ');
+        s.stripSpaces();
+    }
+    return true;
+}
+
+/**
+ * Pre-scan helper for a name specification in @p s.
+ * Returns -1 for a regular name, or the compression index. @p name
+ * is set to the name given, which is null for a compression reference.
+ */
+int CachegrindLoader::scanCompressed(FixString& s, QString& name)
+{
+    FixString rest;
+    int index = splitCompressed(s, rest);
+
+    if (index < 0) {
+        name = s;
+        return -1;
+    }
+    name = rest.isEmpty() ? QString() : QString(rest);
+
+    return index;
+}
+
+/**
+ * Split the data section of @p file into about @p count chunks.
+ * Returns false if the file cannot be parsed in chunks, e.g.
+ * as it contains multiple parts.
+ */
+bool CachegrindLoader::scanChunks(FixFile& file, int count, qint64& headerEnd,
+                                  QList<CachegrindChunk>& chunks,
+                                  CachegrindNames& names)
+{
+    FixString line;
+    char c;
+    int lineNo = 0;
+    bool inData = false;
+    bool lineInfo = true, addrInfo = false;
+    qint64 step = 0, nextStart = 0;
+
+    // current names as seen by the parser
+    QString object, fnFile, curFile;
+    QString calledObject, calledFile, jumpFile;
+    bool hasCalledObject = false, hasCalledFile = false, hasJumpFile = false;
+    // called/jump names are reset after the next cost line
+    bool resetAfterCost = false;
+
+    CachegrindChunk candidate;
+    bool hasCandidate = false;
+
+    auto startData = [&](qint64 pos) {
+        if (inData) return true;
+        inData = true;
+        headerEnd = pos;
+        step = (file.len() - pos) / count;
+        if (step < CHUNKED_LOAD_MINCHUNK) return false;
+
+        CachegrindChunk first;
+        first.start = pos;
+        first.lineNo = lineNo - 1;
+        chunks.append(first);
+        nextStart = pos + step;
+        return true;
+    };
+
+    auto resolve = [&](FixString& s, QVector<QString>& table) {
+        QString name;
+        int index = scanCompressed(s, name);
+        if (index >= 0) {
+            if (name.isNull())
+                return (index < table.size()) ?
+                           QString(checkUnknown(table.at(index))) : QString();
+            if (table.size() <= index) table.resize(index * 2 + 1);
+            table[index] = name;
+        }
+        return QString(checkUnknown(name));
+    };
+
+    auto defineFunction = [&](FixString& s, const QString& f,
+                              const QString& o) {
+        QString name;
+        int index = scanCompressed(s, name);
+        if ((index < 0) || name.isNull()) return;
+        if (names.functions.size() <= index)
+            names.functions.resize(index * 2 + 1);
+        CachegrindFunctionName& fn = names.functions[index];
+        fn.name = name;
+        fn.file = f;
+        fn.object = o;
+    };
+
+    while (true) {
+        // the caller checks for a canceled load after a failed scan
+        if (((lineNo & 0xfff) == 0) && _data->loadCanceled()) return false;
+
+        qint64 pos = file.current();
+        if (!file.nextLine(line)) break;
+        lineNo++;
+
+        if (!line.first(c) || (c == '#')) continue;
+
+        if (c <= '9') {
+            // a position, i.e. a cost line
+            if (!startData(pos)) return false;
+
+            if (hasCandidate) {
+                if (isAbsolutePosition(line, addrInfo, lineInfo)) {
+                    chunks.last().end = candidate.start;
+                    chunks.append(candidate);
+                    nextStart = candidate.start + step;
+                }
+                hasCandidate = false;
+            }
+            if (resetAfterCost) {
+                hasCalledObject = hasCalledFile = hasJumpFile = false;
+                resetAfterCost = false;
+            }
+            continue;
+        }
+
+        if (line.stripPrefix("fn=")) {
+            if (!startData(pos)) return false;
+
+            if ((pos >= nextStart) && !resetAfterCost &&
+                !hasCalledObject && !hasCalledFile && !hasJumpFile) {
+                candidate.start = pos;
+                candidate.lineNo = lineNo - 1;
+                candidate.object = object;
+                candidate.file = fnFile;
+                hasCandidate = true;
+            }
+            curFile = fnFile;
+            defineFunction(line, curFile, object);
+            continue;
+        }
+
+        if (line.stripPrefix("fl=")) {
+            if (!startData(pos)) return false;
+            curFile = fnFile = resolve(line, names.files);
+            continue;
+        }
+
+        if (line.stripPrefix("fi=") || line.stripPrefix("fe=")) {
+            if (!startData(pos)) return false;
+            curFile = resolve(line, names.files);
+            continue;
+        }
+
+        if (line.stripPrefix("ob=")) {
+            if (!startData(pos)) return false;
+            object = resolve(line, names.objects);
+            continue;
+        }
+
+        if (line.stripPrefix("cob=")) {
+            calledObject = resolve(line, names.objects);
+            hasCalledObject = true;
+            continue;
+        }
+
+        if (line.stripPrefix("cfi=") || line.stripPrefix("cfl=")) {
+            calledFile = resolve(line, names.files);
+            hasCalledFile = true;
+            continue;
+        }
+
+        if (line.stripPrefix("cfn=")) {
+            if (!hasCalledObject) calledObject = object;
+            if (!hasCalledFile) calledFile = curFile;
+            hasCalledObject = hasCalledFile = true;
+            defineFunction(line, calledFile, calledObject);
+            continue;
+        }
+
+        if (line.stripPrefix("jfi=")) {
+            jumpFile = resolve(line, names.files);
+            hasJumpFile = true;
+            continue;
+        }
+
+        if (line.stripPrefix("jfn=")) {
+            if (!hasJumpFile) jumpFile = curFile;
+            hasJumpFile = true;
+            defineFunction(line, jumpFile, object);
+            continue;
+        }
+
+        if (line.stripPrefix("calls=") || line.stripPrefix("rcalls=") ||
+            line.stripPrefix("jump=") || line.stripPrefix("jcnd=")) {
+            resetAfterCost = true;
+            continue;
+        }
+
+        if (line.stripPrefix("positions:")) {
+            if (inData) return false;
+            QString positions(line);
+            lineInfo = positions.contains(QLatin1String("line"));
+            addrInfo = positions.contains(QLatin1String("instr"));
+            continue;
+        }
+
+        // these start a new part
+        if (inData &&
+            (line.stripPrefix("events:") || line.stripPrefix("part:") ||
+             line.stripPrefix("pid:") || line.stripPrefix("thread:")))
+            return false;
+    }
+
+    if (chunks.count() < 2) return false;
+    chunks.last().end = file.len();
+
+    return true;
+}
+
+/**
+ * Parse the header and chunk @p chunk of @p file into part of @p data.
+ * Only with @p reportHeader, problems in the header are reported.
+ */
+bool CachegrindLoader::loadChunk(TraceData* data, FixFile& file,
+                                 qint64 headerEnd,
+                                 const CachegrindChunk& chunk,
+                                 const CachegrindNames* names,
+                                 bool reportHeader)
+{
+    _data = data;
+    _lineNo = 0;
+
+    _part = nullptr;
+    partsAdded = 0;
+    prepareNewPart();
+
+    nextLineType  = SelfCost;
+    hasLineInfo = true;
+    hasAddrInfo = false;
+
+    Logger* logger = _logger;
+    if (!reportHeader) _logger = nullptr;
+    FixFile header(file, 0, headerEnd);
+    bool ok = parseLines(header);
+    _logger = logger;
+    if (!ok) return false;
+
+    // state at chunk start, as found by the pre-scan
+    _names = names;
+    if (!chunk.object.isNull()) {
+        currentObject = _data->object(chunk.object);
+        currentPartObject = currentObject->partObject(_part);
+    }
+    if (!chunk.file.isNull()) {
+        currentFile = _data->file(chunk.file);
+        currentFunctionFile = currentFile;
+        currentPartFile = currentFile->partFile(_part);
+    }
+
+    _lineNo = chunk.lineNo;
+    FixFile body(file, chunk.start, chunk.end);
+    ok = parseLines(body);
+    // pending detail uses the pre-scanned names
+    if (ok && mapping) finishDetail();
+    _names = nullptr;
+    if (!ok) return false;
+
+    if (!mapping) {
         error(QStringLiteral("No data found. Skipping file"));
         delete _part;
+        return false;
     }
 
-    device->close();
-
-    return partsAdded;
+    _part->invalidate();
+    _data->addPart(_part);
+    return true;
 }
 
+/**
+ * Load a big single-part file by parsing chunks in parallel.
+ * Returns -1 if the file cannot be loaded this way.
+ */
+int CachegrindLoader::loadChunked(FixFile& file, int threads)
+{
+    CachegrindNames names;
+    QList<CachegrindChunk> chunks;
+    qint64 headerEnd;
+
+    // use more chunks than threads for load balancing
+    if (!scanChunks(file, 2 * threads, headerEnd, chunks, names)) {
+        if (_data->loadCanceled()) return 0;
+        file.rewind();
+        return -1;
+    }
+
+    int count = chunks.count();
+    QList<CachegrindLoader*> loaders;
+    QList<TraceData*> loaded;
+    QList<BufferedLogger*> messages;
+    QVector<int> chunkLoaded(count, 0);
+    QAtomicInt done = 0;
+
+    for (int i = 0; i < count; i++) {
+        BufferedLogger* m = new BufferedLogger;
+        TraceData* d = new TraceData(m);
+        d->setNumberParts(false);
+        d->setLoadParent(_data);
+        CachegrindLoader* l = new CachegrindLoader;
+        l->setLogger(m);
+        l->_filename = _filename;
+        if (_detail) l->_detail = new CachegrindDetail(_filename);
+        messages.append(m);
+        loaded.append(d);
+        loaders.append(l);
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    int* chunkLoadedPtr = chunkLoaded.data();
+    for (int i = 0; i < count; i++) {
+        CachegrindLoader* l = loaders[i];
+        TraceData* d = loaded[i];
+        const CachegrindChunk* chunk = &chunks.at(i);
+        const CachegrindNames* n = &names;
+        FixFile* f = &file;
+        int* result = chunkLoadedPtr + i;
+        pool.start([l, d, f, headerEnd, chunk, n, result, i, &done]() {
+            *result = l->loadChunk(d, *f, headerEnd, *chunk, n, i == 0);
+            done.ref();
+        });
+    }
+    while (!pool.waitForDone(100))
+        loadProgress(100 * done.loadRelaxed() / count);
+
+    // fuse chunks in file order into the part of the first chunk
+    TracePart* part = nullptr;
+    bool failed = false;
+    for (int i = 0; i < count; i++) {
+        messages[i]->forward(_logger);
+        if (!chunkLoaded[i] || _data->loadCanceled())
+            failed = true;
+        else if (!failed) {
+            if (!part) {
+                part = loaded[i]->parts().first();
+                _data->merge(loaded[i]);
+            }
+            else
+                _data->merge(loaded[i], part);
+        }
+        delete loaders[i];
+        delete loaded[i];
+        delete messages[i];
+    }
+    if (!part || _data->loadCanceled()) return 0;
+
+    part->invalidate();
+    part->totals()->clear();
+    part->totals()->addCost(part);
+
+    return 1;
+}
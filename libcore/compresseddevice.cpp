@@ -0,0 +1,239 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-FileCopyrightText: 2026 KCachegrind Authors
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Streaming decompression of profile data files
+ */
+
+#include "compresseddevice.h"
+
+#if HAVE_ZLIB
+#include <zlib.h>
+#endif
+#if HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// size of compressed input read at once from the underlying device
+#define COMPRESSED_INPUT_SIZE (256*1024)
+
+
+CompressedDevice::CompressedDevice(QIODevice* device)
+{
+    _device = device;
+    _compression = device ? compression(device) : None;
+    _inputPos = _inputLen = 0;
+    _frameEnd = _streamEnd = false;
+    _decoder = nullptr;
+}
+
+CompressedDevice::~CompressedDevice()
+{
+    freeDecoder();
+}
+
+CompressedDevice::Compression CompressedDevice::compression(QIODevice* device)
+{
+    if (!device || !device->isOpen()) return None;
+
+    QByteArray magic = device->peek(4);
+    if (magic.startsWith("\x1f\x8b"))
+        return Gzip;
+    if (magic == QByteArray("\x28\xb5\x2f\xfd", 4))
+        return Zstd;
+
+    return None;
+}
+
+bool CompressedDevice::isSupported(Compression c)
+{
+    switch(c) {
+#if HAVE_ZLIB
+    case Gzip: return true;
+#endif
+#if HAVE_ZSTD
+    case Zstd: return true;
+#endif
+    default: break;
+    }
+    return false;
+}
+
+bool CompressedDevice::open(OpenMode mode)
+{
+    if ((mode & WriteOnly) || !(mode & ReadOnly)) {
+        setErrorString(QStringLiteral("Compressed device is read-only"));
+        return false;
+    }
+    if (!_device || !_device->isOpen()) {
+        setErrorString(QStringLiteral("Compressed data not readable"));
+        return false;
+    }
+    if (!initDecoder()) {
+        setErrorString(QStringLiteral("Compression format not supported"));
+        return false;
+    }
+
+    _input.resize(COMPRESSED_INPUT_SIZE);
+    _inputPos = _inputLen = 0;
+    _frameEnd = _streamEnd = false;
+
+    return QIODevice::open(mode);
+}
+
+void CompressedDevice::close()
+{
+    freeDecoder();
+    _input.clear();
+    QIODevice::close();
+}
+
+bool CompressedDevice::initDecoder()
+{
+    freeDecoder();
+
+    switch(_compression) {
+#if HAVE_ZLIB
+    case Gzip: {
+        z_stream* z = new z_stream;
+        z->zalloc = Z_NULL;
+        z->zfree = Z_NULL;
+        z->opaque = Z_NULL;
+        z->next_in = Z_NULL;
+        z->avail_in = 0;
+        // 16: expect gzip header
+        if (inflateInit2(z, 15 + 16) != Z_OK) {
+            delete z;
+            return false;
+        }
+        _decoder = z;
+        return true;
+    }
+#endif
+#if HAVE_ZSTD
+    case Zstd: {
+        ZSTD_DStream* zs = ZSTD_createDStream();
+        if (!zs) return false;
+        ZSTD_initDStream(zs);
+        _decoder = zs;
+        return true;
+    }
+#endif
+    default: break;
+    }
+    return false;
+}
+
+void CompressedDevice::freeDecoder()
+{
+    if (!_decoder) return;
+
+    switch(_compression) {
+#if HAVE_ZLIB
+    case Gzip:
+        inflateEnd((z_stream*) _decoder);
+        delete (z_stream*) _decoder;
+        break;
+#endif
+#if HAVE_ZSTD
+    case Zstd:
+        ZSTD_freeDStream((ZSTD_DStream*) _decoder);
+        break;
+#endif
+    default: break;
+    }
+    _decoder = nullptr;
+}
+
+// returns false at end of compressed data or on read error
+bool CompressedDevice::fillInput()
+{
+    qint64 read = _device->read(_input.data(), _input.size());
+    if (read <= 0) {
+        _inputPos = _inputLen = 0;
+        return false;
+    }
+    _inputPos = 0;
+    _inputLen = read;
+    return true;
+}
+
+// one decoding step from the input buffer, returns bytes written to @p data
+qint64 CompressedDevice::decode(char* data, qint64 maxSize)
+{
+    switch(_compression) {
+#if HAVE_ZLIB
+    case Gzip: {
+        z_stream* z = (z_stream*) _decoder;
+        // data following a finished member is another gzip member
+        if (_frameEnd) inflateReset(z);
+
+        uInt outSize = (uInt) qMin(maxSize, (qint64) (1 << 30));
+        z->next_in = (Bytef*) _input.data() + _inputPos;
+        z->avail_in = (uInt) (_inputLen - _inputPos);
+        z->next_out = (Bytef*) data;
+        z->avail_out = outSize;
+        int res = inflate(z, Z_NO_FLUSH);
+        _inputPos = _inputLen - z->avail_in;
+        if ((res != Z_OK) && (res != Z_STREAM_END) && (res != Z_BUF_ERROR)) {
+            setErrorString(z->msg ? QString::fromLatin1(z->msg) :
+                                    QStringLiteral("Invalid gzip data"));
+            return -1;
+        }
+        _frameEnd = (res == Z_STREAM_END);
+        return outSize - z->avail_out;
+    }
+#endif
+#if HAVE_ZSTD
+    case Zstd: {
+        ZSTD_inBuffer in = { _input.constData() + _inputPos,
+                             (size_t) (_inputLen - _inputPos), 0 };
+        ZSTD_outBuffer out = { data, (size_t) maxSize, 0 };
+        size_t res = ZSTD_decompressStream((ZSTD_DStream*) _decoder, &out, &in);
+        if (ZSTD_isError(res)) {
+            setErrorString(QString::fromLatin1(ZSTD_getErrorName(res)));
+            return -1;
+        }
+        _inputPos += in.pos;
+        // 0: frame completely decoded and flushed
+        _frameEnd = (res == 0);
+        return out.pos;
+    }
+#endif
+    default: break;
+    }
+    return -1;
+}
+
+qint64 CompressedDevice::readData(char* data, qint64 maxSize)
+{
+    if (!_decoder) return -1;
+
+    qint64 done = 0;
+    while ((done < maxSize) && !_streamEnd) {
+        if ((_inputPos == _inputLen) && !fillInput()) {
+            if (!_frameEnd) {
+                setErrorString(QStringLiteral("Unexpected end of compressed data"));
+                return (done > 0) ? done : -1;
+            }
+            _streamEnd = true;
+            break;
+        }
+
+        qint64 decoded = decode(data + done, maxSize - done);
+        if (decoded < 0)
+            return (done > 0) ? done : -1;
+        done += decoded;
+    }
+    return done;
+}
+
+qint64 CompressedDevice::writeData(const char*, qint64)
+{
+    return -1;
+}
@@ -0,0 +1,74 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-FileCopyrightText: 2026 KCachegrind Authors
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Streaming decompression of profile data files
+ */
+
+#ifndef COMPRESSEDDEVICE_H
+#define COMPRESSEDDEVICE_H
+
+#include <QByteArray>
+#include <QIODevice>
+
+/**
+ * Read-only, sequential device providing the decompressed contents of
+ * another device, decoded on demand in small steps. Only the input
+ * buffer and the decoder state are kept in memory.
+ *
+ * Supported formats depend on the libraries found at build time
+ * (zlib for gzip, libzstd for zstd), see isSupported().
+ * Concatenated gzip members and multiple zstd frames are decoded
+ * one after the other.
+ *
+ * The underlying device has to be open, and is neither closed nor
+ * deleted by this device.
+ */
+class CompressedDevice: public QIODevice
+{
+public:
+    enum Compression { None = 0, Gzip, Zstd };
+
+    explicit CompressedDevice(QIODevice* device);
+    ~CompressedDevice() override;
+
+    // detect compression of open @p device by magic bytes at start
+    static Compression compression(QIODevice* device);
+    // was support for compression @p c compiled in?
+    static bool isSupported(Compression c);
+
+    Compression compression() const { return _compression; }
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override { return true; }
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    bool fillInput();
+    qint64 decode(char* data, qint64 maxSize);
+    bool initDecoder();
+    void freeDecoder();
+
+    QIODevice* _device;
+    Compression _compression;
+
+    // compressed input not yet consumed by the decoder
+    QByteArray _input;
+    qint64 _inputPos, _inputLen;
+    // decoder at end of a gzip member / zstd frame, all data delivered
+    bool _frameEnd, _streamEnd;
+
+    // z_stream or ZSTD_DStream, depending on compression
+    void* _decoder;
+};
+
+#endif // COMPRESSEDDEVICE_H
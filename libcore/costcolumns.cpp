@@ -0,0 +1,125 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-FileCopyrightText: 2026 KCachegrind Authors
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Columnar snapshot of the costs of many cost items
+ */
+
+#include "costcolumns.h"
+
+#include <algorithm>
+
+#include "costitem.h"
+#include "eventtype.h"
+
+
+//---------------------------------------------------
+// CostColumns
+
+CostColumns::CostColumns()
+{
+    _count = 0;
+    _realCount = 0;
+}
+
+void CostColumns::clear()
+{
+    _data.clear();
+    _values.clear();
+    _count = 0;
+    _realCount = 0;
+}
+
+void CostColumns::set(const QList<ProfileCostArray*>& items, int realCount)
+{
+    if (realCount > ProfileCostArray::MaxRealIndex)
+        realCount = ProfileCostArray::MaxRealIndex;
+    if (realCount < 0) realCount = 0;
+
+    _count = items.count();
+    _realCount = realCount;
+    _values.clear();
+    _data.fill(0, _count * _realCount);
+    uint64* d = _data.data();
+
+    // gather rows into columns: this is the only pass over the items
+    for(int row = 0; row < _count; row++) {
+        ProfileCostArray* item = items.at(row);
+        if (!item) continue;
+        if (item->_dirty) item->update();
+
+        int n = (item->_count < _realCount) ? item->_count : _realCount;
+        for(int r = 0; r < n; r++)
+            d[r * _count + row] = item->_cost[r];
+    }
+}
+
+const uint64* CostColumns::column(int realIndex) const
+{
+    if ((realIndex < 0) || (realIndex >= _realCount)) return nullptr;
+    return _data.constData() + realIndex * _count;
+}
+
+QVector<uint64> CostColumns::values(EventType* t) const
+{
+    if (!t || (_count == 0)) return QVector<uint64>(_count, 0);
+
+    // results stay valid until next set()
+    QHash<EventType*, QVector<uint64> >::const_iterator it;
+    it = _values.constFind(t);
+    if (it != _values.constEnd()) return it.value();
+
+    QVector<uint64> v(_count, 0);
+    uint64* vd = v.data();
+
+    // sum of the columns in the formula, a real type has only one term
+    int terms = t->termCount();
+    for(int i = 0; i < terms; i++) {
+        const uint64* c = column(t->termIndex(i));
+        if (!c) continue;
+
+        uint64 factor = (uint64) t->termFactor(i);
+        if (factor == 1) {
+            for(int row = 0; row < _count; row++)
+                vd[row] += c[row];
+        }
+        else {
+            for(int row = 0; row < _count; row++)
+                vd[row] += factor * c[row];
+        }
+    }
+
+    _values.insert(t, v);
+    return v;
+}
+
+QVector<int> CostColumns::order(EventType* t, bool descending) const
+{
+    QVector<int> rows(_count);
+    for(int row = 0; row < _count; row++)
+        rows[row] = row;
+
+    QVector<uint64> v = values(t);
+    const uint64* vd = v.constData();
+    if (descending)
+        std::stable_sort(rows.begin(), rows.end(),
+                         [vd](int r1, int r2) { return vd[r1] > vd[r2]; });
+    else
+        std::stable_sort(rows.begin(), rows.end(),
+                         [vd](int r1, int r2) { return vd[r1] < vd[r2]; });
+
+    return rows;
+}
+
+int CostColumns::maxRow(EventType* t) const
+{
+    if (_count == 0) return -1;
+
+    QVector<uint64> v = values(t);
+    return std::max_element(v.constBegin(), v.constEnd()) - v.constBegin();
+}
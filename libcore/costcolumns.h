@@ -0,0 +1,67 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-FileCopyrightText: 2026 KCachegrind Authors
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Columnar snapshot of the costs of many cost items
+ */
+
+#ifndef COSTCOLUMNS_H
+#define COSTCOLUMNS_H
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+#include "subcost.h"
+
+class ProfileCostArray;
+class EventType;
+
+/**
+ * Costs of a list of cost items of the same context level (e.g. all
+ * functions, or the inclusive costs of all functions), stored as one
+ * contiguous array of uint64 per real event type. The row of an item
+ * is its index in the list given to set().
+ *
+ * Values of event types, sort orders and maxima are computed with
+ * tight loops over whole columns, which the compiler can vectorize,
+ * instead of a virtual subCost() call per item and event type.
+ *
+ * This is a snapshot: after costs change (e.g. by activating other
+ * parts), set() has to be called again.
+ */
+class CostColumns
+{
+public:
+    CostColumns();
+
+    // take costs of @p items for the first @p realCount real event types
+    void set(const QList<ProfileCostArray*>& items, int realCount);
+    void clear();
+
+    // number of rows, i.e. items
+    int count() const { return _count; }
+    int realCount() const { return _realCount; }
+
+    // costs of real event type @p realIndex, one value per row
+    const uint64* column(int realIndex) const;
+
+    // values of event type @p t (real or derived) per row, cached per type
+    QVector<uint64> values(EventType* t) const;
+    // rows sorted by value of @p t, stable for equal values
+    QVector<int> order(EventType* t, bool descending = true) const;
+    // row with maximal value of @p t, -1 if empty
+    int maxRow(EventType* t) const;
+
+private:
+    QVector<uint64> _data;
+    int _count, _realCount;
+    mutable QHash<EventType*, QVector<uint64> > _values;
+};
+
+#endif // COSTCOLUMNS_H
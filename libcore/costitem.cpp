@@ -8,6 +8,7 @@
 
 #include "costitem.h"
 
+#include <QAtomicInteger>
 #include <QObject>
 
 #include "tracedata.h"
@@ -118,11 +119,16 @@ const TraceData* CostItem::data() const
 const int ProfileCostArray::MaxRealIndex = MaxRealIndexValue;
 const int ProfileCostArray::InvalidIndex = -1;
 
+// statistics for the event type value cache, see setCacheCounting()
+static bool countCacheAccess = false;
+static QAtomicInteger<quint64> cacheHitCount;
+static QAtomicInteger<quint64> cacheMissCount;
+
 
 ProfileCostArray::ProfileCostArray(ProfileContext* context)
     : CostItem(context)
 {
-    _cachedType = nullptr; // no virtual value cached
+    clearCachedCosts(); // no virtual value cached
     _allocCount = 0;
     _count = 0;
     _cost = nullptr;
@@ -131,7 +137,7 @@ ProfileCostArray::ProfileCostArray(ProfileContext* context)
 ProfileCostArray::ProfileCostArray()
     : CostItem(ProfileContext::context(ProfileContext::UnknownType))
 {
-    _cachedType = nullptr; // no virtual value cached
+    clearCachedCosts(); // no virtual value cached
     _allocCount = 0;
     _count = 0;
     _cost = nullptr;
@@ -214,9 +220,11 @@ void ProfileCostArray::set(EventTypeMapping* mapping, FixString & s)
 
     reserve(mapping->set()->realCount());
 
+    bool skip = mapping->hasSkipped();
     if (mapping->isIdentity()) {
         int i = 0;
         while(i<mapping->count()) {
+            if (skip) mapping->skipValues(s, i);
             if (!s.stripUInt64(_cost[i])) break;
             i++;
         }
@@ -228,6 +236,7 @@ void ProfileCostArray::set(EventTypeMapping* mapping, FixString & s)
             index = mapping->realIndex(i);
             if (maxIndex<index) maxIndex=index;
             if (index == ProfileCostArray::InvalidIndex) break;
+            if (skip) mapping->skipValues(s, i);
             if (!s.stripUInt64(_cost[index])) break;
             i++;
         }
@@ -300,9 +309,11 @@ void ProfileCostArray::addCost(EventTypeMapping* mapping, FixString & s)
     reserve(mapping->set()->realCount());
 
     SubCost v;
+    bool skip = mapping->hasSkipped();
     if (mapping->isIdentity()) {
         int i = 0;
         while(i<mapping->count()) {
+            if (skip) mapping->skipValues(s, i);
             if (!s.stripUInt64(v)) break;
             if (i<_count)
                 _cost[i] += v;
@@ -315,6 +326,7 @@ void ProfileCostArray::addCost(EventTypeMapping* mapping, FixString & s)
     else {
         int i = 0, maxIndex = 0, index;
         while(1) {
+            if (skip) mapping->skipValues(s, i);
             if (!s.stripUInt64(v)) break;
             index = mapping->realIndex(i);
             if (maxIndex<index) maxIndex=index;
@@ -355,9 +367,11 @@ void ProfileCostArray::maxCost(EventTypeMapping* mapping, FixString & s)
     reserve(mapping->set()->realCount());
 
     SubCost v;
+    bool skip = mapping->hasSkipped();
     if (mapping->isIdentity()) {
         int i = 0;
         while(i<mapping->count()) {
+            if (skip) mapping->skipValues(s, i);
             if (!s.stripUInt64(v)) break;
             if (i<_count) {
                 if (v>_cost[i]) _cost[i] = v;
@@ -371,6 +385,7 @@ void ProfileCostArray::maxCost(EventTypeMapping* mapping, FixString & s)
     else {
         int i = 0, maxIndex = 0, index;
         while(1) {
+            if (skip) mapping->skipValues(s, i);
             if (!s.stripUInt64(v)) break;
             index = mapping->realIndex(i);
             if (maxIndex<index) maxIndex=index;
@@ -439,6 +454,32 @@ void ProfileCostArray::addCost(ProfileCostArray* item)
 #endif
 }
 
+void ProfileCostArray::addCostDelta(ProfileCostArray* item, bool subtract)
+{
+    int i;
+    if (!item) return;
+
+    if (item->_dirty) item->update();
+
+    reserve(item->_count);
+    for (i = _count; i<item->_count; ++i)
+        _cost[i] = 0;
+    if (_count < item->_count)
+        _count = item->_count;
+
+    if (subtract) {
+        for (i = 0; i<item->_count; ++i)
+            _cost[i] -= item->_cost[i];
+    }
+    else {
+        for (i = 0; i<item->_count; ++i)
+            _cost[i] += item->_cost[i];
+    }
+
+    // values of derived event types changed, but we stay valid
+    clearCachedCosts();
+}
+
 void ProfileCostArray::maxCost(ProfileCostArray* item)
 {
     int i;
@@ -555,7 +596,7 @@ void ProfileCostArray::invalidate()
 {
     if (_dirty) return;
     _dirty = true;
-    _cachedType = nullptr; // cached value is invalid, too
+    clearCachedCosts(); // cached values are invalid, too
 
     if (_dep)
         _dep->invalidate();
@@ -583,11 +624,60 @@ SubCost ProfileCostArray::subCost(int idx)
 SubCost ProfileCostArray::subCost(EventType* t)
 {
     if (!t) return 0;
-    if (_cachedType != t) {
-        _cachedType = t;
-        _cachedCost = t->subCost(this);
+
+    for(int i=0; i<CachedTypes; i++)
+        if (_cachedType[i] == t) {
+            if (countCacheAccess) cacheHitCount.fetchAndAddRelaxed(1);
+            return _cachedCost[i];
+        }
+
+    if (countCacheAccess) cacheMissCount.fetchAndAddRelaxed(1);
+    SubCost v = t->subCost(this);
+    setCachedCost(t, v);
+    return v;
+}
+
+void ProfileCostArray::setCachedCost(EventType* t, SubCost v)
+{
+    if (_cachedType[0] == t) {
+        _cachedCost[0] = v;
+        return;
+    }
+
+    // most recently set value first, drop the oldest one
+    for(int i=CachedTypes-1; i>0; i--) {
+        _cachedType[i] = _cachedType[i-1];
+        _cachedCost[i] = _cachedCost[i-1];
     }
-    return _cachedCost;
+    _cachedType[0] = t;
+    _cachedCost[0] = v;
+}
+
+void ProfileCostArray::clearCachedCosts()
+{
+    for(int i=0; i<CachedTypes; i++)
+        _cachedType[i] = nullptr;
+}
+
+void ProfileCostArray::setCacheCounting(bool b)
+{
+    countCacheAccess = b;
+}
+
+quint64 ProfileCostArray::cacheHits()
+{
+    return cacheHitCount.loadRelaxed();
+}
+
+quint64 ProfileCostArray::cacheMisses()
+{
+    return cacheMissCount.loadRelaxed();
+}
+
+void ProfileCostArray::resetCacheCounters()
+{
+    cacheHitCount.storeRelaxed(0);
+    cacheMissCount.storeRelaxed(0);
 }
 
 QString ProfileCostArray::prettySubCost(EventType* t)
@@ -134,6 +134,7 @@ protected:
 class ProfileCostArray: public CostItem
 {
     friend class EventType;
+    friend class CostColumns;
 public:
     /**
      */
@@ -161,6 +162,11 @@ public:
     // add the cost of another item
     void addCost(ProfileCostArray* item);
     void addCost(int index, SubCost value);
+    /* Add or subtract the cost of another item, which was added before.
+     * Unlike addCost(), this item is not invalidated: it is used to update
+     * sums incrementally (see TraceData::activateParts).
+     */
+    void addCostDelta(ProfileCostArray* item, bool subtract = false);
 
     // maximal cost
     void maxCost(EventTypeMapping*, FixString&);
@@ -182,20 +188,33 @@ public:
 
     QString prettySubCostPerCall(EventType* t, uint64 calls);
 
+    /* Statistics for the cache of event type values over all items.
+     * Counting is off by default, as it slows down subCost().
+     */
+    static void setCacheCounting(bool);
+    static quint64 cacheHits();
+    static quint64 cacheMisses();
+    static void resetCacheCounters();
+
 protected:
     void update() override;
 
 private:
     // Only used by friend class EventType: return subcost by index
     SubCost subCost(int);
+    // put value @p v of event type @p t into cache
+    void setCachedCost(EventType* t, SubCost v);
+    void clearCachedCosts();
 
     SubCost* _cost;
     int _count; // only _count first indexes of _cost are used
     int _allocCount; // number of allocated subcost entries
 
-    // cache last virtual subcost for faster access
-    SubCost _cachedCost;
-    EventType* _cachedType;
+    // cache last virtual subcosts for faster access: views show
+    // a primary and a secondary event type at the same time
+    enum { CachedTypes = 2 };
+    SubCost _cachedCost[CachedTypes];
+    EventType* _cachedType[CachedTypes];
 };
 
 
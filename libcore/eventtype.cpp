@@ -9,6 +9,7 @@
 #include "eventtype.h"
 
 #include <QRegularExpression>
+#include <QMutex>
 #include <QDebug>
 
 #include "globalconfig.h"
@@ -18,6 +19,10 @@
 
 QList<EventType*>* EventType::_knownTypes = nullptr;
 
+// profile files can be loaded in parallel, and "event:" lines
+// add to the application wide known types
+static QMutex knownTypesMutex;
+
 EventType::EventType(const QString& name, const QString& longName,
                      const QString& formula)
 {
@@ -29,6 +34,7 @@ EventType::EventType(const QString& name, const QString& longName,
     _realIndex = ProfileCostArray::InvalidIndex;
     _parsed = false;
     _inParsing = false;
+    _termCount = 0;
 
     for (int i=0; i<ProfileCostArray::MaxRealIndex;i++)
         _coefficient[i] = 0;
@@ -40,6 +46,7 @@ void EventType::setFormula(const QString& formula)
     _realIndex = ProfileCostArray::InvalidIndex;
     _parsed = false;
     _isReal = false;
+    _termCount = 0;
 }
 
 void EventType::setEventTypeSet(EventTypeSet* m)
@@ -58,6 +65,14 @@ void EventType::setRealIndex(int i)
     _realIndex = i;
     _formula = QString();
     _isReal = true;
+
+    // a real type is its own single term
+    _termCount = 0;
+    if (_realIndex != ProfileCostArray::InvalidIndex) {
+        _termIndex[0] = _realIndex;
+        _termFactor[0] = 1;
+        _termCount = 1;
+    }
 }
 
 // checks for existing types and sets coefficients
@@ -133,6 +148,16 @@ bool EventType::parseFormula()
     }
 
     _inParsing = false;
+
+    // compile into terms: only few of the coefficients are non-zero
+    _termCount = 0;
+    for (int i=0; i<ProfileCostArray::MaxRealIndex;i++) {
+        if (_coefficient[i] == 0) continue;
+        _termIndex[_termCount] = i;
+        _termFactor[_termCount] = _coefficient[i];
+        _termCount++;
+    }
+
     if (found == 0) {
         // empty formula
         _parsedFormula = QStringLiteral("0");
@@ -192,14 +217,50 @@ SubCost EventType::subCost(ProfileCostArray* c)
     }
     SubCost res = 0;
 
-    int rc = _set->realCount();
-    for (int i = 0;i<rc;i++)
-        if (_coefficient[i] != 0)
-            res += _coefficient[i] * c->subCost(i);
+    for (int i = 0;i<_termCount;i++)
+        res += _termFactor[i] * c->subCost(_termIndex[i]);
 
     return res;
 }
 
+void EventType::subCosts(const QList<ProfileCostArray*>& items,
+                         SubCost* results)
+{
+    int count = items.count();
+
+    if (_realIndex != ProfileCostArray::InvalidIndex) {
+        for (int n = 0;n<count;n++)
+            results[n] = items.at(n)->subCost(_realIndex);
+        return;
+    }
+
+    if (!_parsed && !parseFormula()) {
+        for (int n = 0;n<count;n++)
+            results[n] = 0;
+        return;
+    }
+
+    for (int n = 0;n<count;n++) {
+        ProfileCostArray* c = items.at(n);
+        if (c->_dirty) c->update();
+
+        // costs not set in an item are zero
+        uint64 res = 0;
+        for (int i = 0;i<_termCount;i++)
+            if (_termIndex[i] < c->_count)
+                res += (uint64) _termFactor[i] * c->_cost[_termIndex[i]];
+
+        results[n] = res;
+        c->setCachedCost(this, res);
+    }
+}
+
+int EventType::termCount()
+{
+    if (!_parsed && !parseFormula()) return 0;
+    return _termCount;
+}
+
 int EventType::histCost(ProfileCostArray* c, double total, double* hist)
 {
     if (total == 0.0) return 0;
@@ -222,6 +283,7 @@ int EventType::histCost(ProfileCostArray* c, double total, double* hist)
 
 bool EventType::hasKnownRealType(const QString& n)
 {
+    QMutexLocker locker(&knownTypesMutex);
     if (!_knownTypes) return false;
 
     foreach (EventType* t, *_knownTypes)
@@ -233,6 +295,7 @@ bool EventType::hasKnownRealType(const QString& n)
 
 bool EventType::hasKnownDerivedType(const QString& n)
 {
+    QMutexLocker locker(&knownTypesMutex);
     if (!_knownTypes) return false;
 
     foreach (EventType* t, *_knownTypes)
@@ -244,6 +307,7 @@ bool EventType::hasKnownDerivedType(const QString& n)
 
 EventType* EventType::cloneKnownRealType(const QString& n)
 {
+    QMutexLocker locker(&knownTypesMutex);
     if (!_knownTypes) return nullptr;
 
     foreach (EventType* t, *_knownTypes)
@@ -258,6 +322,7 @@ EventType* EventType::cloneKnownRealType(const QString& n)
 
 EventType* EventType::cloneKnownDerivedType(const QString& n)
 {
+    QMutexLocker locker(&knownTypesMutex);
     if (!_knownTypes) return nullptr;
 
     foreach (EventType* t, *_knownTypes)
@@ -276,6 +341,7 @@ void EventType::add(EventType* t, bool overwriteExisting)
 
     t->setEventTypeSet(nullptr);
 
+    QMutexLocker locker(&knownTypesMutex);
     if (!_knownTypes)
         _knownTypes = new QList<EventType*>;
 
@@ -307,6 +373,7 @@ int EventType::knownTypeCount()
 
 bool EventType::remove(const QString& n)
 {
+    QMutexLocker locker(&knownTypesMutex);
     if (!_knownTypes) return false;
 
     foreach (EventType* t, *_knownTypes)
@@ -348,7 +415,8 @@ EventTypeSet::~EventTypeSet()
         delete _derived[i];
 }
 
-EventTypeMapping* EventTypeSet::createMapping(const QString& types)
+EventTypeMapping* EventTypeSet::createMapping(const QString& types,
+                                             const QStringList& selection)
 {
     // first check if there is enough space in the set
     int newCount = 0;
@@ -362,7 +430,9 @@ EventTypeMapping* EventTypeSet::createMapping(const QString& types)
         while((pos2<len) && !types[pos2].isSpace()) pos2++;
         if (pos2 == pos) break;
 
-        if (realIndex(types.mid(pos,pos2-pos)) == ProfileCostArray::InvalidIndex)
+        QString t = types.mid(pos,pos2-pos);
+        if ((selection.isEmpty() || selection.contains(t)) &&
+            (realIndex(t) == ProfileCostArray::InvalidIndex))
             newCount++;
 
         pos = pos2;
@@ -386,7 +456,11 @@ EventTypeMapping* EventTypeSet::createMapping(const QString& types)
         while((pos2<len) && !types[pos2].isSpace()) pos2++;
         if (pos2 == pos) break;
 
-        mapping->append(addReal(types.mid(pos,pos2-pos)));
+        QString t = types.mid(pos,pos2-pos);
+        if (selection.isEmpty() || selection.contains(t))
+            mapping->append(addReal(t));
+        else
+            mapping->skip();
 
         pos = pos2;
     }
@@ -582,11 +656,39 @@ void EventTypeMapping::clear()
 {
     _count = 0;
     _isIdentity = true;
+    _hasSkipped = false;
     _firstUnused = 0;
     for(int i=0;i<ProfileCostArray::MaxRealIndex;i++) {
         _realIndex[i] = ProfileCostArray::InvalidIndex;
         _nextUnused[i] = i+1;
+        _skipBefore[i] = 0;
     }
+    _skipBefore[ProfileCostArray::MaxRealIndex] = 0;
+}
+
+void EventTypeMapping::skip()
+{
+    _skipBefore[_count]++;
+    _hasSkipped = true;
+}
+
+void EventTypeMapping::skipValues(FixString& s, int i)
+{
+    if ((i<0) || (i>_count)) return;
+
+    uint64 v;
+    int64 sv;
+    for(int n = _skipBefore[i]; n>0; n--)
+        if (!s.stripUInt64(v) && !s.stripInt64(sv)) return;
+}
+
+void EventTypeMapping::copySkipped(EventTypeMapping* m)
+{
+    if (!m || (m->_count != _count)) return;
+
+    _hasSkipped = m->_hasSkipped;
+    for(int i=0;i<=_count;i++)
+        _skipBefore[i] = m->_skipBefore[i];
 }
 
 int EventTypeMapping::maxRealIndex(int count)
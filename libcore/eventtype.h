@@ -9,7 +9,9 @@
 #ifndef EVENTTYPE_H
 #define EVENTTYPE_H
 
+#include <QList>
 #include <QString>
+#include <QStringList>
 
 #include "subcost.h"
 #include "costitem.h"
@@ -67,6 +69,21 @@ public:
     QString parsedRealFormula();
 
     SubCost subCost(ProfileCostArray*);
+    /*
+     * Evaluates this type for all @p items into @p results, which must
+     * have space for items.count() values. The results are also put into
+     * the virtual value cache of each item.
+     */
+    void subCosts(const QList<ProfileCostArray*>& items, SubCost* results);
+
+    /*
+     * The formula of a derived type compiled into terms with non-zero
+     * factor: value is sum of termFactor(i) * cost of termIndex(i).
+     * A real type has one term with factor 1.
+     */
+    int termCount();
+    int termIndex(int i) { return _termIndex[i]; }
+    int termFactor(int i) { return _termFactor[i]; }
 
     /*
      * For virtual costs, returns a histogram for use with
@@ -94,6 +111,10 @@ private:
     // index MaxRealIndex is for constant addition
     int _coefficient[MaxRealIndexValue];
     int _realIndex;
+    // sparse form of _coefficient, set up in parseFormula()
+    int _termCount;
+    int _termIndex[MaxRealIndexValue];
+    int _termFactor[MaxRealIndexValue];
 
     static QList<EventType*>* _knownTypes;
 };
@@ -115,8 +136,11 @@ public:
     /**
      * Defines a mapping from indexes into a list of costs to real event types
      * @param types the types
+     * @param selection if not empty, only these types are mapped. Others
+     *        are skipped, and do not get a real event type in this set
      */
-    EventTypeMapping* createMapping(const QString& types);
+    EventTypeMapping* createMapping(const QString& types,
+                                    const QStringList& selection = QStringList());
 
     // "knows" about some real types
     int addReal(const QString&);
@@ -199,12 +223,26 @@ public:
         if (i<0 || i>=ProfileCostArray::MaxRealIndex) return ProfileCostArray::InvalidIndex;
         return _nextUnused[i]; }
 
+    /**
+     * Columns of cost lines not selected for loading, see
+     * EventTypeSet::createMapping(). skip() marks the next column as
+     * skipped. When parsing, call skipValues(s, i) before the value
+     * for mapping index i to drop the values of skipped columns.
+     */
+    void skip();
+    bool hasSkipped() { return _hasSkipped; }
+    void skipValues(FixString& s, int i);
+    // take over skipped columns of mapping @p m with same count
+    void copySkipped(EventTypeMapping* m);
+
 private:
     EventTypeSet* _set;
     int _count, _firstUnused;
-    bool _isIdentity;
+    bool _isIdentity, _hasSkipped;
     int _realIndex[MaxRealIndexValue];
     int _nextUnused[MaxRealIndexValue];
+    // number of skipped columns before the value for a mapping index
+    int _skipBefore[MaxRealIndexValue+1];
 };
 
 
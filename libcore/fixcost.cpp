@@ -10,25 +10,93 @@
 #include "utils.h"
 #include "addr.h"
 
-// FixCost
+// Compact encoding of counters
+//
+// A bit mask with bit i set if counter i is non-zero, followed by the
+// non-zero values as variable-length integers: 7 bits per byte, low
+// bits first, with the high bit set if more bytes follow.
 
-FixCost::FixCost(TracePart* part, FixPool* pool,
-                 TraceFunctionSource* functionSource,
-                 PositionSpec& pos,
-                 TracePartFunction* partFunction,
-                 FixString& s)
+static inline int maskSize(int count)
 {
-    int maxCount = part->eventTypeMapping()->count();
+    return (count + 7) / 8;
+}
 
-    _part = part;
-    _functionSource = functionSource;
-    _pos = pos;
+// upper limit of bytes needed to encode @p count values
+static inline int maxEncodedSize(int count)
+{
+    return maskSize(count) + 10 * count;
+}
+
+static inline unsigned char* putValue(unsigned char* p, uint64 v)
+{
+    while(v >= 0x80) {
+        *p++ = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (unsigned char) v;
+    return p;
+}
+
+static inline const unsigned char* getValue(const unsigned char* p, uint64& v)
+{
+    v = *p & 0x7f;
+    int shift = 7;
+    while(*p++ & 0x80) {
+        v |= (uint64)(*p & 0x7f) << shift;
+        shift += 7;
+    }
+    return p;
+}
+
+// encode @p count values of @p cost to @p p, returns bytes written
+static int encodeCosts(unsigned char* p, int count, const SubCost* cost)
+{
+    int mask = maskSize(count);
+    unsigned char* v = p + mask;
+    for(int i=0; i<mask; i++)
+        p[i] = 0;
+    for(int i=0; i<count; i++) {
+        if (cost[i] == 0) continue;
+        p[i>>3] |= (unsigned char)(1 << (i&7));
+        v = putValue(v, cost[i]);
+    }
+    return v - p;
+}
+
+static void decodeCosts(const unsigned char* p, int count, SubCost* cost)
+{
+    int mask = maskSize(count);
+    const unsigned char* v = p + mask;
+    for(int i=0; i<count; i++) {
+        if (p[i>>3] & (1 << (i&7)))
+            v = getValue(v, cost[i]);
+        else
+            cost[i] = 0;
+    }
+}
+
+static int encodedCostsSize(const unsigned char* p, int count)
+{
+    int mask = maskSize(count);
+    const unsigned char* v = p + mask;
+    uint64 dummy;
+    for(int i=0; i<count; i++)
+        if (p[i>>3] & (1 << (i&7)))
+            v = getValue(v, dummy);
+    return v - p;
+}
+
+// parse up to count values from @p s into @p cost, returns values found
+static int parseCosts(EventTypeMapping* sm, FixString& s, SubCost* cost)
+{
+    int maxCount = sm->count();
+    bool skip = sm->hasSkipped();
 
-    _cost = (SubCost*) pool->reserve(sizeof(SubCost) * maxCount);
     s.stripSpaces();
     int i = 0;
     while(i<maxCount) {
-        if (!s.stripUInt64(_cost[i])) {
+        if (skip) sm->skipValues(s, i);
+        if (!s.stripUInt64(cost[i])) {
             // xdebug used to emit negative costs if it freed memory. It no
             // longer does this. However, old cachegrind files still exist,
             // and they cause KCacheGrind to constantly print messages about
@@ -39,16 +107,57 @@ FixCost::FixCost(TracePart* part, FixPool* pool,
             // [1]: xdebug commit 688c552e620dc5be7eea22cb893c6b71f395c6d4
             int64 temp;
             if (s.stripInt64(temp) && temp < 0) {
-                _cost[i] = 0;
+                cost[i] = 0;
             } else {
                 break;
             }
         }
         i++;
     }
-    _count = i;
+    return i;
+}
+
+
+// FixCost
+
+FixCost::FixCost(TracePart* part, FixPool* pool,
+                 TraceFunctionSource* functionSource,
+                 PositionSpec& pos,
+                 TracePartFunction* partFunction,
+                 FixString& s)
+{
+    SubCost cost[MaxRealIndexValue];
+
+    _part = part;
+    _functionSource = functionSource;
+    _pos = pos;
+
+    _count = parseCosts(part->eventTypeMapping(), s, cost);
+
+    _data = (unsigned char*) pool->reserve(maxEncodedSize(_count));
+    if (!pool->allocateReserved(encodeCosts(_data, _count, cost)))
+        _count = 0;
+
+    _nextCostOfPartFunction = partFunction ?
+                                  partFunction->setFirstFixCost(this) : nullptr;
+}
+
+FixCost::FixCost(TracePart* part, FixPool* pool,
+                 TraceFunctionSource* functionSource,
+                 PositionSpec& pos,
+                 TracePartFunction* partFunction,
+                 int count, const SubCost* cost)
+{
+    int maxCount = part->eventTypeMapping()->count();
+    if (count > maxCount) count = maxCount;
 
-    if (!pool->allocateReserved(sizeof(SubCost) * _count))
+    _part = part;
+    _functionSource = functionSource;
+    _pos = pos;
+
+    _count = count;
+    _data = (unsigned char*) pool->reserve(maxEncodedSize(_count));
+    if (!pool->allocateReserved(encodeCosts(_data, _count, cost)))
         _count = 0;
 
     _nextCostOfPartFunction = partFunction ?
@@ -64,15 +173,31 @@ void FixCost::addTo(ProfileCostArray* c)
 {
     EventTypeMapping* sm = _part->eventTypeMapping();
 
-    int i, realIndex;
+    int mask = maskSize(_count);
+    const unsigned char* v = _data + mask;
+    uint64 value;
 
     c->reserve(sm->maxRealIndex(_count)+1);
-    for(i=0; i<_count; i++) {
-        realIndex = sm->realIndex(i);
-        c->addCost(realIndex, _cost[i]);
+    for(int m=0; m<mask; m++) {
+        unsigned char bits = _data[m];
+        for(int i=m*8; bits; i++, bits >>= 1) {
+            if (!(bits & 1)) continue;
+            v = getValue(v, value);
+            c->addCost(sm->realIndex(i), value);
+        }
     }
 }
 
+void FixCost::costs(SubCost* cost) const
+{
+    decodeCosts(_data, _count, cost);
+}
+
+int FixCost::encodedSize() const
+{
+    return encodedCostsSize(_data, _count);
+}
+
 
 
 // FixCallCost
@@ -87,34 +212,42 @@ FixCallCost::FixCallCost(TracePart* part, FixPool* pool,
                   qPrintable(addr.toString()), line,
                   qPrintable(callCount.pretty()));
 
-    int maxCount = part->eventTypeMapping()->count();
+    SubCost cost[MaxRealIndexValue];
 
     _part = part;
     _functionSource = functionSource;
     _line = line;
     _addr = addr;
 
-    _cost = (SubCost*) pool->reserve(sizeof(SubCost) * (maxCount+1));
-    s.stripSpaces();
-    int i = 0;
-    while(i<maxCount) {
-        if (!s.stripUInt64(_cost[i])) {
-            // Same case as in the FixCost ctor.
-            int64 temp;
-            if (s.stripInt64(temp) && temp < 0) {
-                _cost[i] = 0;
-            } else {
-                break;
-            }
-        }
-        i++;
-    }
-    _count = i;
+    _count = parseCosts(part->eventTypeMapping(), s, cost);
 
-    if (!pool->allocateReserved(sizeof(SubCost) * (_count+1) ))
+    _data = (unsigned char*) pool->reserve(10 + maxEncodedSize(_count));
+    unsigned char* p = putValue(_data, callCount);
+    if (!pool->allocateReserved((p - _data) + encodeCosts(p, _count, cost)))
+        _count = 0;
+
+    _nextCostOfPartCall = partCall ? partCall->setFirstFixCallCost(this) : nullptr;
+}
+
+FixCallCost::FixCallCost(TracePart* part, FixPool* pool,
+                         TraceFunctionSource* functionSource,
+                         unsigned int line, Addr addr,
+                         TracePartCall* partCall,
+                         SubCost callCount, int count, const SubCost* cost)
+{
+    int maxCount = part->eventTypeMapping()->count();
+    if (count > maxCount) count = maxCount;
+
+    _part = part;
+    _functionSource = functionSource;
+    _line = line;
+    _addr = addr;
+
+    _count = count;
+    _data = (unsigned char*) pool->reserve(10 + maxEncodedSize(_count));
+    unsigned char* p = putValue(_data, callCount);
+    if (!pool->allocateReserved((p - _data) + encodeCosts(p, _count, cost)))
         _count = 0;
-    else
-        _cost[_count] = callCount;
 
     _nextCostOfPartCall = partCall ? partCall->setFirstFixCallCost(this) : nullptr;
 }
@@ -124,33 +257,53 @@ void* FixCallCost::operator new(size_t size, FixPool* pool)
     return pool->allocate(size);
 }
 
+SubCost FixCallCost::callCount() const
+{
+    uint64 v;
+    getValue(_data, v);
+    return v;
+}
+
 void FixCallCost::addTo(TraceCallCost* c)
 {
     EventTypeMapping* sm = _part->eventTypeMapping();
 
-    int i, realIndex;
+    SubCost cost[MaxRealIndexValue];
+    uint64 calls;
+    decodeCosts(getValue(_data, calls), _count, cost);
 
-    for(i=0; i<_count; i++) {
-        realIndex = sm->realIndex(i);
-        c->addCost(realIndex, _cost[i]);
-    }
-    c->addCallCount(_cost[_count]);
+    for(int i=0; i<_count; i++)
+        c->addCost(sm->realIndex(i), cost[i]);
+    c->addCallCount(calls);
 
     if (0) qDebug("Adding from (addr 0x%s, ln %d): calls %s",
                   qPrintable(_addr.toString()), _line,
-                  qPrintable(_cost[_count].pretty()));
+                  qPrintable(SubCost(calls).pretty()));
 }
 
 void FixCallCost::setMax(ProfileCostArray* c)
 {
     EventTypeMapping* sm = _part->eventTypeMapping();
 
-    int i, realIndex;
+    SubCost cost[MaxRealIndexValue];
+    uint64 calls;
+    decodeCosts(getValue(_data, calls), _count, cost);
 
-    for(i=0; i<_count; i++) {
-        realIndex = sm->realIndex(i);
-        c->maxCost(realIndex, _cost[i]);
-    }
+    for(int i=0; i<_count; i++)
+        c->maxCost(sm->realIndex(i), cost[i]);
+}
+
+void FixCallCost::costs(SubCost* cost) const
+{
+    uint64 calls;
+    decodeCosts(getValue(_data, calls), _count, cost);
+}
+
+int FixCallCost::encodedSize() const
+{
+    uint64 calls;
+    const unsigned char* p = getValue(_data, calls);
+    return (p - _data) + encodedCostsSize(p, _count);
 }
 
 
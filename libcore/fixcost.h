@@ -38,7 +38,11 @@ public:
  * A class holding an unchangable cost item of an input file.
  *
  * As there can be a lot of such cost items, we use our own
- * allocator which uses FixPool
+ * allocator which uses FixPool.
+ *
+ * Counters are stored compactly: a bit mask with a bit set for each
+ * non-zero counter, followed by the non-zero values as variable-length
+ * integers. Profiles from cache simulation have mostly zero miss counters.
  */
 class FixCost
 {
@@ -49,12 +53,26 @@ public:
             PositionSpec&,
             TracePartFunction*,
             FixString&);
+    // with <count> already parsed costs (e.g. from a profile cache)
+    FixCost(TracePart*, FixPool*,
+            TraceFunctionSource*,
+            PositionSpec&,
+            TracePartFunction*,
+            int count, const SubCost*);
 
     void *operator new(size_t size, FixPool*);
 
     void addTo(ProfileCostArray*);
 
     TracePart* part() const { return _part; }
+    // costs in order of the event type mapping of the part
+    int count() const { return _count; }
+    // decode the count() costs into @p cost
+    void costs(SubCost* cost) const;
+    // bytes used for the costs, and without compact encoding
+    int encodedSize() const;
+    int rawSize() const { return _count * sizeof(SubCost); }
+    const PositionSpec& position() const { return _pos; }
     bool isLineRegion() const { return _pos.isLineRegion(); }
     bool isAddrRegion() const { return _pos.isAddrRegion(); }
     uint fromLine() const { return _pos.fromLine; }
@@ -64,13 +82,18 @@ public:
     Addr addr() const { return _pos.fromAddr; }
     Addr toAddr() const { return _pos.toAddr; }
     TraceFunctionSource* functionSource() const { return _functionSource; }
+    // when moving parts into another TraceData (see TraceData::merge)
+    void setFunctionSource(TraceFunctionSource* s) { _functionSource = s; }
+    void setPart(TracePart* p) { _part = p; }
+    void setNextCostOfPartFunction(FixCost* fc)
+    { _nextCostOfPartFunction = fc; }
 
     FixCost* nextCostOfPartFunction() const
     { return _nextCostOfPartFunction; }
 
 private:
     int _count;
-    SubCost*  _cost;
+    unsigned char* _data;
     PositionSpec _pos;
 
     TracePart* _part;
@@ -93,6 +116,13 @@ public:
                 Addr addr,
                 TracePartCall*,
                 SubCost, FixString&);
+    // with <count> already parsed costs (e.g. from a profile cache)
+    FixCallCost(TracePart*, FixPool*,
+                TraceFunctionSource*,
+                unsigned int line,
+                Addr addr,
+                TracePartCall*,
+                SubCost, int count, const SubCost*);
 
     void *operator new(size_t size, FixPool*);
 
@@ -102,15 +132,27 @@ public:
     TracePart* part() const { return _part; }
     unsigned int line() const { return _line; }
     Addr addr() const { return _addr; }
-    SubCost callCount() const { return _cost[_count]; }
+    SubCost callCount() const;
+    // costs in order of the event type mapping of the part
+    int count() const { return _count; }
+    // decode the count() costs into @p cost
+    void costs(SubCost* cost) const;
+    // bytes used for call count and costs, and without compact encoding
+    int encodedSize() const;
+    int rawSize() const { return (_count+1) * sizeof(SubCost); }
     TraceFunctionSource* functionSource() const	{ return _functionSource; }
+    // when moving parts into another TraceData (see TraceData::merge)
+    void setFunctionSource(TraceFunctionSource* s) { _functionSource = s; }
+    void setPart(TracePart* p) { _part = p; }
+    void setNextCostOfPartCall(FixCallCost* fc)
+    { _nextCostOfPartCall = fc; }
     FixCallCost* nextCostOfPartCall() const
     { return _nextCostOfPartCall; }
 
 private:
-    // we use 1 SubCost more than _count: _cost[_count] is the call count
+    // call count first, followed by the costs as in FixCost
     int _count;
-    SubCost*  _cost;
+    unsigned char* _data;
     unsigned int _line;
     Addr _addr;
 
@@ -149,6 +191,15 @@ public:
     Addr targetAddr() const { return _targetAddr; }
     TraceFunctionSource* targetSource() const { return _targetSource; }
     bool isCondJump() const { return _isCondJump; }
+    // when moving parts into another TraceData (see TraceData::merge)
+    void setSources(TraceFunctionSource* source,
+                    TraceFunction* targetFunction,
+                    TraceFunctionSource* targetSource)
+    { _source = source; _targetFunction = targetFunction;
+      _targetSource = targetSource; }
+    void setPart(TracePart* p) { _part = p; }
+    void setNextJumpOfPartFunction(FixJump* fj)
+    { _nextJumpOfPartFunction = fj; }
     SubCost executedCount() const { return _cost[0]; }
     SubCost followedCount() const
     { return _isCondJump ? _cost[1] : SubCost(0); }
@@ -30,6 +30,10 @@
 #define DEFAULT_MAXLISTCOUNT     100
 #define DEFAULT_CONTEXT          3
 #define DEFAULT_NOCOSTINSIDE     20
+#define DEFAULT_LOADTHREADS      0
+#define DEFAULT_USELOADCACHE     false
+#define DEFAULT_LOADDETAILONDEMAND false
+#define DEFAULT_PARTPREFIXSUMS   false
 
 
 //
@@ -126,6 +130,14 @@ GlobalConfig::GlobalConfig()
     // annotation behaviour
     _context          = DEFAULT_CONTEXT;
     _noCostInside     = DEFAULT_NOCOSTINSIDE;
+
+    // loading
+    _loadThreads      = DEFAULT_LOADTHREADS;
+    _useLoadCache     = DEFAULT_USELOADCACHE;
+    _loadDetailOnDemand = DEFAULT_LOADDETAILONDEMAND;
+
+    // updating
+    _partPrefixSums   = DEFAULT_PARTPREFIXSUMS;
 }
 
 GlobalConfig::~GlobalConfig()
@@ -183,6 +195,14 @@ void GlobalConfig::saveOptions()
                             DEFAULT_NOCOSTINSIDE);
     generalConfig->setValue(QStringLiteral("HideTemplates"), _hideTemplates,
                             DEFAULT_HIDETEMPLATES);
+    generalConfig->setValue(QStringLiteral("LoadThreads"), _loadThreads,
+                            DEFAULT_LOADTHREADS);
+    generalConfig->setValue(QStringLiteral("UseLoadCache"), _useLoadCache,
+                            DEFAULT_USELOADCACHE);
+    generalConfig->setValue(QStringLiteral("LoadDetailOnDemand"),
+                            _loadDetailOnDemand, DEFAULT_LOADDETAILONDEMAND);
+    generalConfig->setValue(QStringLiteral("PartPrefixSums"), _partPrefixSums,
+                            DEFAULT_PARTPREFIXSUMS);
     delete generalConfig;
 
     // store known event types
@@ -254,6 +274,14 @@ void GlobalConfig::readOptions()
                                              DEFAULT_NOCOSTINSIDE).toInt();
     _hideTemplates    = generalConfig->value(QStringLiteral("HideTemplates"),
                                              DEFAULT_HIDETEMPLATES).toBool();
+    _loadThreads      = generalConfig->value(QStringLiteral("LoadThreads"),
+                                             DEFAULT_LOADTHREADS).toInt();
+    _useLoadCache     = generalConfig->value(QStringLiteral("UseLoadCache"),
+                                             DEFAULT_USELOADCACHE).toBool();
+    _loadDetailOnDemand = generalConfig->value(QStringLiteral("LoadDetailOnDemand"),
+                                               DEFAULT_LOADDETAILONDEMAND).toBool();
+    _partPrefixSums   = generalConfig->value(QStringLiteral("PartPrefixSums"),
+                                             DEFAULT_PARTPREFIXSUMS).toBool();
     delete generalConfig;
 
     // event types
@@ -341,6 +369,21 @@ bool GlobalConfig::hideTemplates()
     return config()->_hideTemplates;
 }
 
+bool GlobalConfig::useLoadCache()
+{
+    return config()->_useLoadCache;
+}
+
+bool GlobalConfig::loadDetailOnDemand()
+{
+    return config()->_loadDetailOnDemand;
+}
+
+bool GlobalConfig::partPrefixSums()
+{
+    return config()->_partPrefixSums;
+}
+
 void GlobalConfig::setShowPercentage(bool s)
 {
     GlobalConfig* c = config();
@@ -373,6 +416,35 @@ void GlobalConfig::setHideTemplates(bool s)
     c->_hideTemplates = s;
 }
 
+void GlobalConfig::setUseLoadCache(bool s)
+{
+    GlobalConfig* c = config();
+    if (c->_useLoadCache == s) return;
+
+    c->_useLoadCache = s;
+}
+
+void GlobalConfig::setLoadDetailOnDemand(bool s)
+{
+    GlobalConfig* c = config();
+    if (c->_loadDetailOnDemand == s) return;
+
+    c->_loadDetailOnDemand = s;
+}
+
+void GlobalConfig::setPartPrefixSums(bool s)
+{
+    GlobalConfig* c = config();
+    if (c->_partPrefixSums == s) return;
+
+    c->_partPrefixSums = s;
+}
+
+void GlobalConfig::setLoadEvents(const QStringList& l)
+{
+    config()->_loadEvents = l;
+}
+
 double GlobalConfig::cycleCut()
 {
     return config()->_cycleCut;
@@ -415,6 +487,16 @@ int GlobalConfig::noCostInside()
     return config()->_noCostInside;
 }
 
+int GlobalConfig::loadThreads()
+{
+    return config()->_loadThreads;
+}
+
+QStringList GlobalConfig::loadEvents()
+{
+    return config()->_loadEvents;
+}
+
 void GlobalConfig::setPercentPrecision(int v)
 {
     if ((v<1) || (v >5)) return;
@@ -445,6 +527,12 @@ void GlobalConfig::setContext(int v)
     _context = v;
 }
 
+void GlobalConfig::setLoadThreads(int v)
+{
+    if ((v<0) || (v >256)) return;
+    _loadThreads = v;
+}
+
 const QStringList& GlobalConfig::generalSourceDirs()
 {
     return _generalSourceDirs;
@@ -43,6 +43,12 @@ public:
     static bool showExpanded();
     static bool showCycles();
     static bool hideTemplates();
+    // write/use binary caches next to loaded profile files
+    static bool useLoadCache();
+    // load function summaries first, line/instruction costs when needed
+    static bool loadDetailOnDemand();
+    // sum costs over a range of active parts from cumulative costs per item
+    static bool partPrefixSums();
 
     // lower percentage limit of cost items filled into lists
     static int percentPrecision();
@@ -58,6 +64,11 @@ public:
     static int context();
     // how many lines without cost are still regarded as inside a function
     static int noCostInside();
+    // threads for loading multiple profile files and for updating
+    // costs of all items (0: one per CPU core)
+    static int loadThreads();
+    // event types to load from profile files (empty: all)
+    static QStringList loadEvents();
 
     const QStringList& generalSourceDirs();
     QStringList objectSourceDirs(QString);
@@ -70,6 +81,7 @@ public:
     void setMaxSymbolCount(int);
     void setMaxListCount(int);
     void setContext(int);
+    void setLoadThreads(int);
 
     static void setShowPercentage(bool);
     static void setShowExpanded(bool);
@@ -77,6 +89,10 @@ public:
     static void setShowCycles(bool);
 
     static void setHideTemplates(bool);
+    static void setUseLoadCache(bool);
+    static void setLoadDetailOnDemand(bool);
+    static void setPartPrefixSums(bool);
+    static void setLoadEvents(const QStringList&);
     // upper limit for cutting of a call in cycle detection
     static double cycleCut();
 
@@ -91,10 +107,15 @@ protected:
     QHash<QString, QStringList> _objectSourceDirs;
 
     bool _showPercentage, _showExpanded, _showCycles, _hideTemplates;
+    bool _useLoadCache, _loadDetailOnDemand;
+    bool _partPrefixSums;
     double _cycleCut;
     int _percentPrecision;
     int _maxSymbolLength, _maxSymbolCount, _maxListCount;
     int _context, _noCostInside;
+    int _loadThreads;
+    // not saved: selection only applies to the current session
+    QStringList _loadEvents;
 
     static GlobalConfig* _config;
 };
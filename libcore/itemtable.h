@@ -0,0 +1,423 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-FileCopyrightText: 2026 KCachegrind Authors
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Tables of cost items with a name or a number as key
+ */
+
+#ifndef ITEMTABLE_H
+#define ITEMTABLE_H
+
+#include <algorithm>
+#include <new>
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+/**
+ * Table for the cost items of a TraceData with a name as key, i.e.
+ * objects, files, classes and functions.
+ *
+ * Items are created in an arena of fixed-size blocks and never move,
+ * so pointers to them stay valid as long as the table exists.
+ * A hash index on the key gives constant-time lookup and creation,
+ * which is what loaders need.
+ *
+ * Iteration with begin()/end() is in alphabetical order of keys, as
+ * with a QMap. The sorted view is built on the first iteration after
+ * items were added, merging in only the new ones.
+ * For passes over all items where order does not matter, use at()
+ * with indexes up to count(), which is in order of creation.
+ */
+template<class T>
+class TraceItemTable
+{
+public:
+    class ConstIterator;
+
+    class Iterator
+    {
+    public:
+        Iterator() { _table = nullptr; _pos = 0; }
+        Iterator(TraceItemTable* t, int pos) { _table = t; _pos = pos; }
+
+        const QString& key() const { return _table->_keys.at(index()); }
+        T& value() const { return _table->at(index()); }
+        T& operator*() const { return value(); }
+        T* operator->() const { return &value(); }
+
+        Iterator& operator++() { _pos++; return *this; }
+        Iterator operator++(int) { Iterator it = *this; _pos++; return it; }
+        Iterator& operator--() { _pos--; return *this; }
+        Iterator operator--(int) { Iterator it = *this; _pos--; return it; }
+
+        bool operator==(const Iterator& o) const
+        { return (_table == o._table) && (_pos == o._pos); }
+        bool operator!=(const Iterator& o) const { return !(*this == o); }
+
+    private:
+        friend class ConstIterator;
+        int index() const { return _table->_sorted.at(_pos); }
+
+        TraceItemTable* _table;
+        int _pos;
+    };
+
+    class ConstIterator
+    {
+    public:
+        ConstIterator() { _table = nullptr; _pos = 0; }
+        ConstIterator(const TraceItemTable* t, int pos) { _table = t; _pos = pos; }
+        ConstIterator(const Iterator& it) { _table = it._table; _pos = it._pos; }
+
+        const QString& key() const { return _table->_keys.at(index()); }
+        const T& value() const { return _table->at(index()); }
+        const T& operator*() const { return value(); }
+        const T* operator->() const { return &value(); }
+
+        ConstIterator& operator++() { _pos++; return *this; }
+        ConstIterator operator++(int) { ConstIterator it = *this; _pos++; return it; }
+        ConstIterator& operator--() { _pos--; return *this; }
+        ConstIterator operator--(int) { ConstIterator it = *this; _pos--; return it; }
+
+        bool operator==(const ConstIterator& o) const
+        { return (_table == o._table) && (_pos == o._pos); }
+        bool operator!=(const ConstIterator& o) const { return !(*this == o); }
+
+    private:
+        int index() const { return _table->_sorted.at(_pos); }
+
+        const TraceItemTable* _table;
+        int _pos;
+    };
+
+    typedef Iterator iterator;
+    typedef ConstIterator const_iterator;
+
+    TraceItemTable() { _count = 0; }
+    ~TraceItemTable() { clear(); }
+
+    TraceItemTable(const TraceItemTable&) = delete;
+    TraceItemTable& operator=(const TraceItemTable&) = delete;
+
+    int count() const { return _count; }
+    int size() const { return _count; }
+    bool isEmpty() const { return _count == 0; }
+
+    // item with index @p i, in order of creation
+    T& at(int i) { return _blocks.at(i >> BlockBits)[i & BlockMask]; }
+    const T& at(int i) const { return _blocks.at(i >> BlockBits)[i & BlockMask]; }
+
+    // item with @p key, nullptr if not existing
+    T* value(const QString& key)
+    {
+        int i = _index.value(key, -1);
+        return (i < 0) ? nullptr : &at(i);
+    }
+
+    bool contains(const QString& key) const { return _index.contains(key); }
+
+    // item with @p key, created with the default constructor if new
+    T& operator[](const QString& key)
+    {
+        typename QHash<QString, int>::const_iterator it = _index.constFind(key);
+        if (it != _index.constEnd()) return at(it.value());
+
+        if ((_count & BlockMask) == 0)
+            _blocks.append(new T[BlockSize]);
+        _index.insert(key, _count);
+        _keys.append(key);
+
+        return at(_count++);
+    }
+
+    // position of item with @p key in alphabetical order, end() if not existing
+    Iterator find(const QString& key)
+    {
+        if (!_index.contains(key)) return end();
+
+        sort();
+        QVector<int>::const_iterator it;
+        it = std::lower_bound(_sorted.constBegin(), _sorted.constEnd(), key,
+                              [this](int i, const QString& k) {
+                                  return _keys.at(i) < k;
+                              });
+        return Iterator(this, it - _sorted.constBegin());
+    }
+
+    Iterator begin() { sort(); return Iterator(this, 0); }
+    Iterator end() { return Iterator(this, _count); }
+    ConstIterator begin() const { sort(); return ConstIterator(this, 0); }
+    ConstIterator end() const { return ConstIterator(this, _count); }
+    ConstIterator constBegin() const { return begin(); }
+    ConstIterator constEnd() const { return end(); }
+
+    void clear()
+    {
+        for(int i = 0; i < _blocks.size(); i++)
+            delete [] _blocks.at(i);
+        _blocks.clear();
+        _keys.clear();
+        _index.clear();
+        _sorted.clear();
+        _count = 0;
+    }
+
+private:
+    enum { BlockBits = 8, BlockSize = 1 << BlockBits, BlockMask = BlockSize - 1 };
+
+    // bring sorted view up to date, merging items added since last call
+    void sort() const
+    {
+        int sorted = _sorted.size();
+        if (sorted == _count) return;
+
+        _sorted.resize(_count);
+        for(int i = sorted; i < _count; i++)
+            _sorted[i] = i;
+
+        auto less = [this](int i1, int i2) { return _keys.at(i1) < _keys.at(i2); };
+        std::sort(_sorted.begin() + sorted, _sorted.end(), less);
+        std::inplace_merge(_sorted.begin(), _sorted.begin() + sorted,
+                           _sorted.end(), less);
+    }
+
+    QList<T*> _blocks;
+    QVector<QString> _keys;
+    QHash<QString, int> _index;
+    // indexes of items in alphabetical order of keys
+    mutable QVector<int> _sorted;
+    int _count;
+};
+
+
+/**
+ * Table for the cost items of a function or function source with a
+ * numeric key, i.e. instructions by address and lines by line number.
+ *
+ * Items are constructed in blocks of growing size and never move.
+ * The table keeps a sorted view: a flat vector of keys and one of item
+ * pointers, searched with binary search and walked without touching
+ * any other memory. Items are usually created in ascending key order
+ * and then go directly into the sorted view. Others are pending in a
+ * hash until the next search or iteration merges them in, so that
+ * creating items in any order (e.g. from multiple parts, or when
+ * following a growing file) stays fast.
+ *
+ * The API is the part of QMap used for these tables. Unlike with a
+ * QMap, iterators get invalid when items are added.
+ */
+template<class K, class T>
+class TraceKeyTable
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator() { _table = nullptr; _pos = 0; }
+        Iterator(const TraceKeyTable* t, int pos) { _table = t; _pos = pos; }
+
+        const K& key() const { return _table->_keys.at(_pos); }
+        T& value() const { return *_table->_items.at(_pos); }
+        T& operator*() const { return value(); }
+        T* operator->() const { return &value(); }
+
+        Iterator& operator++() { _pos++; return *this; }
+        Iterator operator++(int) { Iterator it = *this; _pos++; return it; }
+        Iterator& operator--() { _pos--; return *this; }
+        Iterator operator--(int) { Iterator it = *this; _pos--; return it; }
+
+        bool operator==(const Iterator& o) const
+        { return (_table == o._table) && (_pos == o._pos); }
+        bool operator!=(const Iterator& o) const { return !(*this == o); }
+
+    private:
+        const TraceKeyTable* _table;
+        int _pos;
+    };
+
+    typedef Iterator iterator;
+    typedef Iterator ConstIterator;
+    typedef Iterator const_iterator;
+
+    TraceKeyTable() { _count = 0; _free = 0; }
+    ~TraceKeyTable() { clear(); }
+
+    TraceKeyTable(const TraceKeyTable&) = delete;
+    TraceKeyTable& operator=(const TraceKeyTable&) = delete;
+
+    int count() const { return _count; }
+    int size() const { return _count; }
+    bool isEmpty() const { return _count == 0; }
+
+    // item with @p key, nullptr if not existing
+    T* value(const K& key) const
+    {
+        int pos = search(key);
+        if (pos >= 0) return _items.at(pos);
+        return _pending.value(key, nullptr);
+    }
+
+    bool contains(const K& key) const { return value(key) != nullptr; }
+
+    // item with @p key, created with the default constructor if new
+    T& operator[](const K& key)
+    {
+        // usual case while loading: keys in ascending order
+        bool append = _pending.isEmpty() &&
+                      (_keys.isEmpty() || (_keys.last() < key));
+        if (!append) {
+            T* item = value(key);
+            if (item) return *item;
+        }
+
+        T* item = create();
+        if (append) {
+            _keys.append(key);
+            _items.append(item);
+        }
+        else
+            _pending.insert(key, item);
+
+        return *item;
+    }
+
+    // position of item with @p key, end() if not existing
+    Iterator find(const K& key) const
+    {
+        sort();
+        int pos = search(key);
+        return (pos < 0) ? end() : Iterator(this, pos);
+    }
+
+    // first item with key not less than / greater than @p key
+    Iterator lowerBound(const K& key) const
+    {
+        sort();
+        return Iterator(this, std::lower_bound(_keys.constBegin(), _keys.constEnd(),
+                                               key) - _keys.constBegin());
+    }
+    Iterator upperBound(const K& key) const
+    {
+        sort();
+        return Iterator(this, std::upper_bound(_keys.constBegin(), _keys.constEnd(),
+                                               key) - _keys.constBegin());
+    }
+
+    Iterator begin() const { sort(); return Iterator(this, 0); }
+    Iterator end() const { sort(); return Iterator(this, _count); }
+    Iterator constBegin() const { return begin(); }
+    Iterator constEnd() const { return end(); }
+
+    void clear()
+    {
+        int left = _count;
+        for(int b = 0; b < _blocks.size(); b++) {
+            T* block = _blocks.at(b).items;
+            int n = qMin(left, _blocks.at(b).size);
+            for(int i = 0; i < n; i++)
+                block[i].~T();
+            left -= n;
+            ::operator delete(block);
+        }
+        _blocks.clear();
+        _keys.clear();
+        _items.clear();
+        _pending.clear();
+        _count = 0;
+        _free = 0;
+    }
+
+private:
+    struct Block {
+        T* items;
+        int size;
+    };
+
+    // constructs a new item, with memory from the last block
+    T* create()
+    {
+        if (_free == 0) {
+            // Grow by half of the current size, starting with single
+            // items: most tables have only a few items. At most 1/3 of
+            // the allocated items are unused.
+            Block b;
+            b.size = qMax(1, _count / 2);
+            b.items = (T*) ::operator new(b.size * sizeof(T));
+            _blocks.append(b);
+            _free = b.size;
+        }
+
+        const Block& b = _blocks.last();
+        T* item = new (b.items + (b.size - _free)) T();
+        _free--;
+        _count++;
+        return item;
+    }
+
+    // position of @p key in the sorted view, -1 if not there
+    int search(const K& key) const
+    {
+        typename QVector<K>::const_iterator it;
+        it = std::lower_bound(_keys.constBegin(), _keys.constEnd(), key);
+        if ((it == _keys.constEnd()) || !(*it == key)) return -1;
+        return it - _keys.constBegin();
+    }
+
+    // merge pending items into the sorted view
+    void sort() const
+    {
+        if (_pending.isEmpty()) return;
+
+        QVector<K> keys;
+        QVector<T*> items;
+        keys.reserve(_pending.size());
+        for(auto it = _pending.constBegin(); it != _pending.constEnd(); ++it)
+            keys.append(it.key());
+        std::sort(keys.begin(), keys.end());
+        items.reserve(keys.size());
+        for(int i = 0; i < keys.size(); i++)
+            items.append(_pending.value(keys.at(i)));
+        _pending.clear();
+
+        QVector<K> mergedKeys;
+        QVector<T*> mergedItems;
+        mergedKeys.reserve(_keys.size() + keys.size());
+        mergedItems.reserve(_keys.size() + keys.size());
+        int i1 = 0, i2 = 0;
+        while((i1 < _keys.size()) || (i2 < keys.size())) {
+            if ((i2 == keys.size()) ||
+                ((i1 < _keys.size()) && (_keys.at(i1) < keys.at(i2)))) {
+                mergedKeys.append(_keys.at(i1));
+                mergedItems.append(_items.at(i1));
+                i1++;
+            }
+            else {
+                mergedKeys.append(keys.at(i2));
+                mergedItems.append(items.at(i2));
+                i2++;
+            }
+        }
+        _keys = mergedKeys;
+        _items = mergedItems;
+    }
+
+    QVector<Block> _blocks;
+    int _count;
+    // items not yet used in the last block
+    int _free;
+    // sorted view
+    mutable QVector<K> _keys;
+    mutable QVector<T*> _items;
+    // items created out of order, not yet in the sorted view
+    mutable QHash<K, T*> _pending;
+};
+
+#endif // ITEMTABLE_H
@@ -16,22 +16,41 @@ NHEADERS += \
     $$PWD/fixcost.h \
     $$PWD/pool.h \
     $$PWD/coverage.h \
-    $$PWD/stackbrowser.h
+    $$PWD/stackbrowser.h \
+    $$PWD/profilecache.h \
+    $$PWD/compresseddevice.h \
+    $$PWD/itemtable.h \
+    $$PWD/costcolumns.h \
+    $$PWD/nameindex.h
 
 SOURCES += \
     $$PWD/context.cpp \
     $$PWD/costitem.cpp \
+    $$PWD/costcolumns.cpp \
     $$PWD/subcost.cpp \
     $$PWD/eventtype.cpp \
     $$PWD/addr.cpp \
     $$PWD/cachegrindloader.cpp \
+    $$PWD/compresseddevice.cpp \
     $$PWD/config.cpp \
     $$PWD/coverage.cpp \
     $$PWD/fixcost.cpp \
     $$PWD/globalconfig.cpp \
     $$PWD/loader.cpp \
+    $$PWD/nameindex.cpp \
     $$PWD/logger.cpp \
     $$PWD/pool.cpp \
+    $$PWD/profilecache.cpp \
     $$PWD/stackbrowser.cpp \
     $$PWD/tracedata.cpp \
     $$PWD/utils.cpp
+
+# optional decompression of gzip/zstd compressed profile data files
+packagesExist(zlib) {
+    DEFINES += HAVE_ZLIB=1
+    LIBS += -lz
+}
+packagesExist(libzstd) {
+    DEFINES += HAVE_ZSTD=1
+    LIBS += -lzstd
+}
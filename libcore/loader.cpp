@@ -13,6 +13,13 @@
 #include "loader.h"
 
 #include "logger.h"
+#include "compresseddevice.h"
+
+/// DetailSource
+
+DetailSource::~DetailSource()
+{}
+
 
 /// Loader
 
@@ -34,18 +41,41 @@ bool Loader::canLoad(QIODevice*)
     return false;
 }
 
-int Loader::load(TraceData*, QIODevice*, const QString&)
+int Loader::load(TraceData*, QIODevice*, const QString&, Logger*)
+{
+    return 0;
+}
+
+int Loader::loadAppended(TraceData*, QIODevice*, const QString&,
+                         LoaderPosition&, Logger*)
 {
     return 0;
 }
 
 Loader* Loader::matchingLoader(QIODevice* file)
 {
+    // loaders check the start of the decompressed data
+    CompressedDevice* decompressed = nullptr;
+    if (CompressedDevice::isSupported(CompressedDevice::compression(file))) {
+        decompressed = new CompressedDevice(file);
+        if (!decompressed->open(QIODevice::ReadOnly)) {
+            delete decompressed;
+            return nullptr;
+        }
+    }
+
+    Loader* matching = nullptr;
     foreach (Loader* l, _loaderList)
-        if (l->canLoad(file))
-            return l;
-
-    return nullptr;
+        if (l->canLoad(decompressed ? decompressed : file)) {
+            matching = l;
+            break;
+        }
+
+    if (decompressed) {
+        delete decompressed;
+        file->seek(0);
+    }
+    return matching;
 }
 
 Loader* Loader::loader(const QString& name)
@@ -20,6 +20,43 @@ class QIODevice;
 class TraceData;
 class Loader;
 class Logger;
+class TracePartFunction;
+
+/**
+ * Position reached in a profile data file which still is growing,
+ * see Loader::loadAppended().
+ */
+struct LoaderPosition
+{
+    LoaderPosition() { offset = 0; lineNo = 0; }
+
+    // end of the last complete part loaded
+    qint64 offset;
+    // line number at <offset>, for messages
+    int lineNo;
+};
+
+/**
+ * Detailed costs (per line and instruction, and jumps) of part
+ * functions which were loaded with summary costs only, to be read
+ * when needed. Created by a loader and owned by the TracePart.
+ */
+class DetailSource
+{
+public:
+    virtual ~DetailSource();
+
+    // is detail of @p pf still to be loaded?
+    virtual bool pending(TracePartFunction* pf) const = 0;
+    /* replace the summary fix costs of @p pf by detailed ones.
+     * Returns false if the detail cannot be loaded anymore
+     * (e.g. the profile data file changed). */
+    virtual bool load(TracePartFunction* pf) = 0;
+    /* take over pending detail of @p from in @p other as detail
+     * of @p to, when fusing parts loaded in chunks (see TraceData::merge) */
+    virtual void take(DetailSource* other,
+                      TracePartFunction* from, TracePartFunction* to) = 0;
+};
 
 /**
  * To implement a new loader, inherit from the Loader class and
@@ -49,8 +86,21 @@ public:
     /* load a profile data file.
      * for every section (time span covered by profile), create a TracePart
      * return the number of sections loaded (0 on error)
+     * Notifications go to @p logger if given, otherwise to the logger
+     * set with setLogger(). Loaders are shared, so loads running in
+     * parallel have to pass their logger here.
+     */
+    virtual int load(TraceData*, QIODevice* file, const QString& filename,
+                     Logger* logger = nullptr);
+    /* load parts appended to a profile data file since last call.
+     * Only complete parts after @p pos are loaded, and @p pos is moved
+     * to the end of the last one. Starting with a default position,
+     * this loads all complete parts. Returns the number of parts loaded.
+     * The default implementation does not support this.
      */
-    virtual int load(TraceData*, QIODevice* file, const QString& filename);
+    virtual int loadAppended(TraceData*, QIODevice* file,
+                             const QString& filename, LoaderPosition& pos,
+                             Logger* logger = nullptr);
 
     static Loader* matchingLoader(QIODevice* file);
     static Loader* loader(const QString& name);
@@ -57,3 +57,52 @@ void Logger::loadFinished(const QString& msg)
     else
         qDebug() << "Error loading file" << _filename << ":" << qPrintable(msg);
 }
+
+
+/// BufferedLogger
+
+void BufferedLogger::loadStart(const QString& filename)
+{
+    add(Start, 0, filename);
+}
+
+void BufferedLogger::loadProgress(int)
+{}
+
+void BufferedLogger::loadWarning(int line, const QString& msg)
+{
+    add(Warning, line, msg);
+}
+
+void BufferedLogger::loadError(int line, const QString& msg)
+{
+    add(Error, line, msg);
+}
+
+void BufferedLogger::loadFinished(const QString& msg)
+{
+    add(Finished, 0, msg);
+}
+
+void BufferedLogger::add(Kind kind, int line, const QString& text)
+{
+    Message m;
+    m.kind = kind;
+    m.line = line;
+    m.text = text;
+    _messages.append(m);
+}
+
+void BufferedLogger::forward(Logger* l) const
+{
+    if (!l) return;
+
+    foreach(const Message& m, _messages) {
+        switch(m.kind) {
+        case Start:    l->loadStart(m.text); break;
+        case Warning:  l->loadWarning(m.line, m.text); break;
+        case Error:    l->loadError(m.line, m.text); break;
+        case Finished: l->loadFinished(m.text); break;
+        }
+    }
+}
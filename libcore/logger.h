@@ -18,6 +18,7 @@
 
 #include <qstring.h>
 #include <qtimer.h>
+#include <qlist.h>
 
 class Logger
 {
@@ -38,6 +39,37 @@ private:
     QTimer _timer;
 };
 
+/**
+ * Logger for loading in a worker thread.
+ * Messages are stored, and can be forwarded from the main thread
+ * afterwards, as front ends are not thread-safe.
+ * Progress notifications are dropped.
+ */
+class BufferedLogger: public Logger
+{
+public:
+    void loadStart(const QString& filename) override;
+    void loadProgress(int progress) override;
+    void loadWarning(int line, const QString& msg) override;
+    void loadError(int line, const QString& msg) override;
+    void loadFinished(const QString& msg) override;
+
+    // replay stored messages to @p l in original order
+    void forward(Logger* l) const;
+
+private:
+    enum Kind { Start, Warning, Error, Finished };
+    struct Message {
+        Kind kind;
+        int line;
+        QString text;
+    };
+
+    void add(Kind kind, int line, const QString& text);
+
+    QList<Message> _messages;
+};
+
 #endif // LOGGER_H
 
 
@@ -0,0 +1,133 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-FileCopyrightText: 2026 KCachegrind Authors
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Trigram index for searching in many names
+ */
+
+#include "nameindex.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include <QPair>
+#include <QStringList>
+
+
+//---------------------------------------------------
+// NameIndex
+
+NameIndex::NameIndex()
+{
+    _count = 0;
+}
+
+void NameIndex::clear()
+{
+    _entries.clear();
+    _trigrams.clear();
+    _start.clear();
+    _ids.clear();
+    _count = 0;
+}
+
+QVector<quint64> NameIndex::trigrams(const QString& s)
+{
+    QVector<quint64> res;
+    QString folded = s.toCaseFolded();
+    const QChar* c = folded.constData();
+    int n = folded.length() - 2;
+    if (n <= 0) return res;
+
+    res.reserve(n);
+    for(int i = 0; i < n; i++)
+        res.append(((quint64) c[i].unicode() << 32) |
+                   ((quint64) c[i+1].unicode() << 16) | c[i+2].unicode());
+    std::sort(res.begin(), res.end());
+    res.erase(std::unique(res.begin(), res.end()), res.end());
+    return res;
+}
+
+void NameIndex::add(int id, const QString& name)
+{
+    foreach(quint64 t, trigrams(name)) {
+        Entry e;
+        e.trigram = t;
+        e.id = id;
+        _entries.append(e);
+    }
+    _count++;
+}
+
+void NameIndex::finish()
+{
+    // ids were added in ascending order and stay so per trigram
+    std::stable_sort(_entries.begin(), _entries.end(),
+                     [](const Entry& e1, const Entry& e2)
+    { return e1.trigram < e2.trigram; });
+
+    _trigrams.clear();
+    _start.clear();
+    _ids.clear();
+    _ids.reserve(_entries.count());
+    for(int i = 0; i < _entries.count(); i++) {
+        const Entry& e = _entries.at(i);
+        if (_trigrams.isEmpty() || (_trigrams.last() != e.trigram)) {
+            _trigrams.append(e.trigram);
+            _start.append(_ids.count());
+        }
+        _ids.append(e.id);
+    }
+    _start.append(_ids.count());
+
+    _entries.clear();
+    _entries.squeeze();
+    _trigrams.squeeze();
+    _start.squeeze();
+}
+
+bool NameIndex::candidates(const QString& pattern, QVector<int>& ids) const
+{
+    ids.clear();
+
+    // besides '*', glob2Regex() keeps these as regular expression syntax
+    static const QString special = QStringLiteral("^$+?{}");
+    for(int i = 0; i < special.length(); i++)
+        if (pattern.contains(special[i])) return false;
+
+    // all trigrams of the literal parts must be in a matching name
+    QVector<quint64> wanted;
+    foreach(const QString& part, pattern.split(QChar('*'), Qt::SkipEmptyParts))
+        wanted += trigrams(part);
+    if (wanted.isEmpty()) return false;
+
+    // ranges of ids per trigram, shortest first
+    QVector<QPair<int,int> > ranges;
+    foreach(quint64 t, wanted) {
+        auto it = std::lower_bound(_trigrams.constBegin(), _trigrams.constEnd(), t);
+        if ((it == _trigrams.constEnd()) || (*it != t))
+            return true; // no name matches
+        int i = it - _trigrams.constBegin();
+        ranges.append(qMakePair(_start.at(i), _start.at(i+1)));
+    }
+    std::sort(ranges.begin(), ranges.end(),
+              [](const QPair<int,int>& r1, const QPair<int,int>& r2)
+    { return (r1.second - r1.first) < (r2.second - r2.first); });
+
+    const int* d = _ids.constData();
+    ids = QVector<int>(d + ranges.at(0).first, d + ranges.at(0).second);
+    QVector<int> tmp;
+    for(int r = 1; (r < ranges.count()) && !ids.isEmpty(); r++) {
+        tmp.clear();
+        std::set_intersection(ids.constBegin(), ids.constEnd(),
+                              d + ranges.at(r).first, d + ranges.at(r).second,
+                              std::back_inserter(tmp));
+        ids.swap(tmp);
+    }
+    return true;
+}
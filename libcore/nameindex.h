@@ -0,0 +1,70 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-FileCopyrightText: 2026 KCachegrind Authors
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Trigram index for searching in many names
+ */
+
+#ifndef NAMEINDEX_H
+#define NAMEINDEX_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * Index from each sequence of 3 characters (trigram) to the names
+ * containing it, for names given with an id. It narrows down the names
+ * which can match a search pattern, so that only these have to be
+ * checked with a regular expression.
+ *
+ * Names are compared case-folded, as the searches are case insensitive.
+ * The index is built once: add() all names, then call finish().
+ */
+class NameIndex
+{
+public:
+    NameIndex();
+
+    void clear();
+    // add @p name with @p id, in ascending order of ids
+    void add(int id, const QString& name);
+    // build the lookup structures after all names were added
+    void finish();
+
+    // number of names added
+    int count() const { return _count; }
+
+    /* Ids of all names which can match @p pattern, a glob as used for
+     * the function filter ('*' for any string), in ascending order.
+     * Returns false if the pattern gives no restriction, i.e. it has
+     * no literal part of 3 or more characters, or uses regular
+     * expression syntax. Then, all names have to be checked.
+     */
+    bool candidates(const QString& pattern, QVector<int>& ids) const;
+
+private:
+    struct Entry {
+        quint64 trigram;
+        int id;
+    };
+
+    // trigrams in @p s, sorted and unique
+    static QVector<quint64> trigrams(const QString& s);
+
+    // (trigram, id) pairs collected by add(), until finish()
+    QVector<Entry> _entries;
+    int _count;
+
+    // sorted trigrams; ids of names with trigram i are
+    // _ids[_start[i]] up to _ids[_start[i+1]-1]
+    QVector<quint64> _trigrams;
+    QVector<int> _start;
+    QVector<int> _ids;
+};
+
+#endif // NAMEINDEX_H
@@ -19,7 +19,8 @@
 struct SpaceChunk
 {
     struct SpaceChunk* next;
-    unsigned int used;
+    // 8 bytes, so space starts aligned
+    unsigned long used;
     char space[1];
 };
 
@@ -41,12 +42,17 @@ FixPool::~FixPool()
         chunk = next;
     }
 
-    if (0) qDebug("~FixPool: Had %d objects with total size %d\n",
+    if (0) qDebug("~FixPool: Had %d objects with total size %lu\n",
                   _count, _size);
 }
 
 void* FixPool::allocate(unsigned int size)
 {
+    // objects follow reserved data of any length: keep them aligned
+    if (_last) {
+        unsigned int pad = (0 - (quintptr)(_last->space + _last->used)) & 7;
+        if (_last->used + pad + size <= CHUNK_SIZE) _last->used += pad;
+    }
     if (!ensureSpace(size)) return nullptr;
 
     _reservation = 0;
@@ -81,6 +87,33 @@ bool FixPool::allocateReserved(unsigned int size)
     return true;
 }
 
+void FixPool::merge(FixPool* other)
+{
+    if (!other || (other == this) || !other->_first) return;
+
+    // prepend the chunks of other, keeping our last chunk for allocation
+    other->_last->next = _first;
+    _first = other->_first;
+    if (!_last) _last = other->_last;
+
+    _count += other->_count;
+    _size += other->_size;
+
+    other->_first = other->_last = nullptr;
+    other->_reservation = 0;
+    other->_count = 0;
+    other->_size = 0;
+}
+
+unsigned long FixPool::chunkSize() const
+{
+    unsigned long chunks = 0;
+    for(struct SpaceChunk* chunk = _first; chunk; chunk = chunk->next)
+        chunks++;
+
+    return chunks * (sizeof(struct SpaceChunk) + CHUNK_SIZE);
+}
+
 bool FixPool::ensureSpace(unsigned int size)
 {
     if (_last && _last->used + size <= CHUNK_SIZE) return true;
@@ -228,6 +261,142 @@ bool DynPool::ensureSpace(unsigned int size)
     return true;
 }
 
+
+// NamePool
+
+struct NamePool::LargeName
+{
+    LargeName* next;
+    char str[1];
+};
+
+NamePool::NamePool()
+{
+    _large = nullptr;
+    _names = nullptr;
+    _count = _capacity = 0;
+    _table = nullptr;
+    _tableSize = 0;
+}
+
+NamePool::~NamePool()
+{
+    LargeName* l = _large, *next;
+    while(l) {
+        next = l->next;
+        free(l);
+        l = next;
+    }
+    free(_names);
+    free(_table);
+}
+
+// FNV-1a
+unsigned int NamePool::hash(const char* s, int len)
+{
+    unsigned int h = 2166136261u;
+    for(int i=0; i<len; i++) {
+        h ^= (unsigned char) s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+unsigned int NamePool::slot(const char* s, int len, unsigned int h) const
+{
+    unsigned int mask = _tableSize - 1;
+    unsigned int i = h & mask;
+
+    while(1) {
+        int id = _table[i];
+        if (id < 0) break;
+        const Name& n = _names[id];
+        if ((n.hash == h) && (n.len == len) &&
+            ((len == 0) || (memcmp(n.str, s, len) == 0)))
+            break;
+        i = (i+1) & mask;
+    }
+    return i;
+}
+
+int NamePool::find(const char* s, int len) const
+{
+    if (_count == 0) return -1;
+
+    return _table[slot(s, len, hash(s, len))];
+}
+
+int NamePool::id(const char* s, int len)
+{
+    // keep load factor of hash table below 1/2
+    if (2 * (_count+1) > (int) _tableSize) growTable();
+
+    unsigned int h = hash(s, len);
+    unsigned int i = slot(s, len, h);
+    if (_table[i] >= 0) return _table[i];
+
+    if (_count == _capacity) {
+        _capacity = _capacity ? 2 * _capacity : 1024;
+        _names = (Name*) realloc(_names, _capacity * sizeof(Name));
+        if (!_names) {
+            qFatal("ERROR: Out of memory. Sorry. KCachegrind has to terminate.");
+            exit(1);
+        }
+    }
+
+    Name& n = _names[_count];
+    n.str = store(s, len);
+    n.len = len;
+    n.hash = h;
+    _table[i] = _count;
+
+    return _count++;
+}
+
+const char* NamePool::store(const char* s, int len)
+{
+    if (len == 0) return "";
+
+    // name bytes need no alignment: reserve() does not pad
+    char* str = (char*) _space.reserve(len);
+    if (str)
+        _space.allocateReserved(len);
+    else {
+        // too large for a chunk of the fix pool
+        LargeName* l = (LargeName*) malloc(sizeof(LargeName) + len);
+        if (!l) {
+            qFatal("ERROR: Out of memory. Sorry. KCachegrind has to terminate.");
+            exit(1);
+        }
+        l->next = _large;
+        _large = l;
+        str = l->str;
+    }
+    memcpy(str, s, len);
+    return str;
+}
+
+void NamePool::growTable()
+{
+    unsigned int newSize = _tableSize ? 2 * _tableSize : 2048;
+    free(_table);
+    _table = (int*) malloc(newSize * sizeof(int));
+    if (!_table) {
+        qFatal("ERROR: Out of memory. Sorry. KCachegrind has to terminate.");
+        exit(1);
+    }
+    _tableSize = newSize;
+    memset(_table, 0xff, newSize * sizeof(int));
+
+    // re-insert all names
+    unsigned int mask = _tableSize - 1;
+    for(int id=0; id<_count; id++) {
+        unsigned int i = _names[id].hash & mask;
+        while(_table[i] >= 0) i = (i+1) & mask;
+        _table[i] = id;
+    }
+}
+
 /* Testing the DynPool
 int main()
 {
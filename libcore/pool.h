@@ -47,6 +47,18 @@ public:
      */
     bool allocateReserved(unsigned int size);
 
+    /**
+     * Take over all memory of pool @p other, which is empty afterwards.
+     * Objects allocated in @p other now live as long as this pool.
+     */
+    void merge(FixPool* other);
+
+    // number of allocations, and bytes taken by them
+    int count() const { return _count; }
+    unsigned long size() const { return _size; }
+    // bytes of memory chunks allocated from the system
+    unsigned long chunkSize() const;
+
 private:
     /* Checks that there is enough space in the last chunk.
      * Returns false if this is not possible.
@@ -55,7 +67,8 @@ private:
 
     struct SpaceChunk *_first, *_last;
     unsigned int _reservation;
-    int _count, _size;
+    int _count;
+    unsigned long _size;
 };
 
 /**
@@ -97,4 +110,56 @@ private:
     unsigned int _used, _size;
 };
 
+/**
+ * NamePool
+ *
+ * Interns names given as byte strings, e.g. from a mapped file: each
+ * distinct name is stored once and gets a dense integer ID, counting
+ * from 0 in order of insertion. Looking up a name by its bytes needs
+ * no conversion to QString. Stored names live as long as the pool.
+ */
+class NamePool
+{
+public:
+    NamePool();
+    ~NamePool();
+
+    // ID of name @p s with @p len bytes, added to the pool if new
+    int id(const char* s, int len);
+
+    // ID of name @p s with @p len bytes, -1 if not in the pool
+    int find(const char* s, int len) const;
+
+    // number of names, IDs are in range [0, count()[
+    int count() const { return _count; }
+
+    // bytes of name with @p id, not 0-terminated
+    const char* name(int id) const { return _names[id].str; }
+    int length(int id) const { return _names[id].len; }
+
+private:
+    struct Name {
+        const char* str;
+        int len;
+        unsigned int hash;
+    };
+    struct LargeName;
+
+    static unsigned int hash(const char* s, int len);
+    // slot in hash table for name, holding -1 if not found
+    unsigned int slot(const char* s, int len, unsigned int h) const;
+    const char* store(const char* s, int len);
+    void growTable();
+
+    FixPool _space;
+    // names too large for chunks of _space
+    LargeName* _large;
+
+    Name* _names;
+    int _count, _capacity;
+    // open addressing with size being a power of 2, -1 for free slots
+    int* _table;
+    unsigned int _tableSize;
+};
+
 #endif // POOL_H
@@ -0,0 +1,518 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-FileCopyrightText: 2026 KCachegrind Authors
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Binary cache of loaded profile data
+ */
+
+#include "profilecache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QVector>
+
+#include "addr.h"
+#include "fixcost.h"
+#include "logger.h"
+
+// "KCGC"
+#define CACHE_MAGIC   0x4b434743
+// increment on any change of the layout written in ProfileCache::save
+#define CACHE_VERSION 1
+// bytes at start and end of profile data file included in validity hash
+#define CACHE_HASHSIZE (64*1024)
+
+
+//
+// Helpers
+//
+
+/* Key checked for validity of a cache: size, modification time
+ * and a hash over the start and the end of the profile data file.
+ */
+static bool profileKey(const QString& filename,
+                       qint64& size, qint64& mtime, QByteArray& hash)
+{
+    QFileInfo fi(filename);
+    if (!fi.isFile()) return false;
+    size = fi.size();
+    mtime = fi.lastModified().toMSecsSinceEpoch();
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QCryptographicHash h(QCryptographicHash::Sha1);
+    h.addData(file.read(CACHE_HASHSIZE));
+    if (size > CACHE_HASHSIZE) {
+        file.seek(qMax(size - CACHE_HASHSIZE, (qint64)CACHE_HASHSIZE));
+        h.addData(file.read(CACHE_HASHSIZE));
+    }
+    hash = h.result();
+    return true;
+}
+
+/* Numbering of items written into a cache, in order of first use */
+template<class T>
+class CacheTable
+{
+public:
+    int index(T* item)
+    {
+        if (!item) return -1;
+        typename QHash<T*, int>::const_iterator it = _index.constFind(item);
+        if (it != _index.constEnd()) return it.value();
+        _index.insert(item, _items.count());
+        _items.append(item);
+        return _items.count() - 1;
+    }
+
+    int count() const { return _items.count(); }
+    T* at(int i) const { return _items[i]; }
+
+private:
+    QHash<T*, int> _index;
+    QList<T*> _items;
+};
+
+/* Item with index @p i read from a cache, nullptr if out of range */
+template<class T>
+static T* cacheItem(const QVector<T*>& items, qint32 i)
+{
+    return (i >= 0 && i < items.count()) ? items[i] : nullptr;
+}
+
+static void writeCosts(QDataStream& s, int count, const SubCost* costs)
+{
+    s << (qint32) count;
+    for (int i = 0; i < count; i++)
+        s << (quint64) costs[i];
+}
+
+static bool readCosts(QDataStream& s, QVector<SubCost>& costs)
+{
+    qint32 count;
+    s >> count;
+    if (count < 0 || count > MaxRealIndexValue)
+        return false;
+    costs.resize(count);
+    for (int i = 0; i < count; i++) {
+        quint64 v;
+        s >> v;
+        costs[i] = v;
+    }
+    return s.status() == QDataStream::Ok;
+}
+
+
+//
+// ProfileCache
+//
+
+QString ProfileCache::cacheName(const QString& filename)
+{
+    QFileInfo fi(filename);
+    // hidden, so it never matches as profile data file itself
+    return fi.dir().filePath(QStringLiteral(".%1.kcgcache").arg(fi.fileName()));
+}
+
+
+bool ProfileCache::save(TraceData* data, const TracePartList& parts,
+                        const QString& filename)
+{
+    qint64 size, mtime;
+    QByteArray hash;
+    if (parts.isEmpty() || !profileKey(filename, size, mtime, hash))
+        return false;
+
+    // parts loaded as summary only do not have all fix cost items
+    foreach(TracePart* part, parts)
+        if (part->detailSource()) return false;
+
+    // number all items referenced by the parts
+    CacheTable<TraceObject> objects;
+    CacheTable<TraceFile> files;
+    CacheTable<TraceFunction> functions;
+    CacheTable<TraceFunctionSource> sources;
+
+    foreach(TracePart* part, parts) {
+        foreach(ProfileCostArray* dep, part->deps()) {
+            TracePartFunction* pf = (TracePartFunction*) dep;
+            functions.index(pf->function());
+            for (FixCost* fc = pf->firstFixCost(); fc; fc = fc->nextCostOfPartFunction())
+                sources.index(fc->functionSource());
+            for (FixJump* fj = pf->firstFixJump(); fj; fj = fj->nextJumpOfPartFunction()) {
+                sources.index(fj->source());
+                functions.index(fj->targetFunction());
+                sources.index(fj->targetSource());
+            }
+            foreach(TracePartCall* pc, pf->partCallings()) {
+                functions.index(pc->call()->called());
+                for (FixCallCost* fcc = pc->firstFixCallCost(); fcc;
+                     fcc = fcc->nextCostOfPartCall())
+                    sources.index(fcc->functionSource());
+            }
+        }
+    }
+    for (int i = 0; i < sources.count(); i++) {
+        functions.index(sources.at(i)->function());
+        files.index(sources.at(i)->file());
+    }
+    for (int i = 0; i < functions.count(); i++) {
+        files.index(functions.at(i)->file());
+        objects.index(functions.at(i)->object());
+    }
+    foreach(TracePart* part, parts)
+        foreach(ProfileCostArray* dep, part->deps()) {
+            TracePartFunction* pf = (TracePartFunction*) dep;
+            if (pf->partFile()) files.index(pf->partFile()->file());
+            if (pf->partObject()) objects.index(pf->partObject()->object());
+        }
+
+    QSaveFile out(cacheName(filename));
+    if (!out.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream s(&out);
+    s.setVersion(QDataStream::Qt_6_5);
+    s << (quint32) CACHE_MAGIC << (quint32) CACHE_VERSION
+      << size << mtime << hash;
+    s << data->command() << (qint32) data->architecture();
+
+    s << (qint32) objects.count();
+    for (int i = 0; i < objects.count(); i++)
+        s << objects.at(i)->name();
+    s << (qint32) files.count();
+    for (int i = 0; i < files.count(); i++)
+        s << files.at(i)->name();
+    s << (qint32) functions.count();
+    for (int i = 0; i < functions.count(); i++) {
+        TraceFunction* f = functions.at(i);
+        s << f->name() << (qint32) files.index(f->file())
+          << (qint32) objects.index(f->object());
+    }
+    s << (qint32) sources.count();
+    for (int i = 0; i < sources.count(); i++) {
+        TraceFunctionSource* sf = sources.at(i);
+        s << (qint32) functions.index(sf->function())
+          << (qint32) files.index(sf->file());
+    }
+
+    QVector<SubCost> costs;
+    s << (qint32) parts.count();
+    foreach(TracePart* part, parts) {
+        s << part->name() << part->description() << part->trigger()
+          << part->timeframe() << part->version()
+          << (qint32) part->partNumber() << (qint32) part->threadID()
+          << (qint32) part->processID();
+
+        EventTypeMapping* m = part->eventTypeMapping();
+        QStringList events;
+        costs.resize(m ? m->count() : 0);
+        for (int i = 0; i < costs.count(); i++) {
+            EventType* t = data->eventTypes()->realType(m->realIndex(i));
+            events << t->name();
+            costs[i] = part->totals()->subCost(t);
+        }
+        s << events;
+        writeCosts(s, costs.count(), costs.constData());
+
+        // fix items are prepended to their lists: write in creation order
+        QList<TracePartCall*> partCalls;
+        s << (qint32) part->deps().count();
+        foreach(ProfileCostArray* dep, part->deps()) {
+            TracePartFunction* pf = (TracePartFunction*) dep;
+            s << (qint32) functions.index(pf->function())
+              << (qint32) (pf->partFile() ? files.index(pf->partFile()->file()) : -1)
+              << (qint32) (pf->partObject() ? objects.index(pf->partObject()->object()) : -1);
+
+            QList<FixCost*> fixCosts;
+            for (FixCost* fc = pf->firstFixCost(); fc; fc = fc->nextCostOfPartFunction())
+                fixCosts.append(fc);
+            s << (qint32) fixCosts.count();
+            for (int i = fixCosts.count() - 1; i >= 0; i--) {
+                FixCost* fc = fixCosts[i];
+                const PositionSpec& p = fc->position();
+                s << (qint32) sources.index(fc->functionSource())
+                  << (quint32) p.fromLine << (quint32) p.toLine
+                  << (quint64) p.fromAddr.value() << (quint64) p.toAddr.value();
+                costs.resize(fc->count());
+                fc->costs(costs.data());
+                writeCosts(s, costs.count(), costs.constData());
+            }
+
+            QList<FixJump*> fixJumps;
+            for (FixJump* fj = pf->firstFixJump(); fj; fj = fj->nextJumpOfPartFunction())
+                fixJumps.append(fj);
+            s << (qint32) fixJumps.count();
+            for (int i = fixJumps.count() - 1; i >= 0; i--) {
+                FixJump* fj = fixJumps[i];
+                s << (quint32) fj->line() << (quint64) fj->addr().value()
+                  << (qint32) sources.index(fj->source())
+                  << (quint32) fj->targetLine() << (quint64) fj->targetAddr().value()
+                  << (qint32) functions.index(fj->targetFunction())
+                  << (qint32) sources.index(fj->targetSource())
+                  << fj->isCondJump()
+                  << (quint64) fj->executedCount() << (quint64) fj->followedCount();
+            }
+
+            partCalls.append(pf->partCallings());
+        }
+
+        // calls need both part functions, so they follow all of them
+        s << (qint32) partCalls.count();
+        foreach(TracePartCall* pc, partCalls) {
+            s << (qint32) functions.index(pc->call()->caller())
+              << (qint32) functions.index(pc->call()->called());
+
+            QList<FixCallCost*> fixCosts;
+            for (FixCallCost* fcc = pc->firstFixCallCost(); fcc;
+                 fcc = fcc->nextCostOfPartCall())
+                fixCosts.append(fcc);
+            s << (qint32) fixCosts.count();
+            for (int i = fixCosts.count() - 1; i >= 0; i--) {
+                FixCallCost* fcc = fixCosts[i];
+                s << (qint32) sources.index(fcc->functionSource())
+                  << (quint32) fcc->line() << (quint64) fcc->addr().value()
+                  << (quint64) fcc->callCount();
+                costs.resize(fcc->count());
+                fcc->costs(costs.data());
+                writeCosts(s, costs.count(), costs.constData());
+            }
+        }
+    }
+
+    if (s.status() != QDataStream::Ok) {
+        out.cancelWriting();
+        return false;
+    }
+    return out.commit();
+}
+
+
+/* Read cache contents after the header into @p d.
+ * Returns false on inconsistent data.
+ */
+static bool readCache(QDataStream& s, TraceData* d)
+{
+    QString command;
+    qint32 arch, count;
+    s >> command >> arch;
+    d->setCommand(command);
+    d->setArchitecture((TraceData::Arch) arch);
+
+    QVector<TraceObject*> objects;
+    s >> count;
+    for (int i = 0; i < count && s.status() == QDataStream::Ok; i++) {
+        QString name;
+        s >> name;
+        objects.append(d->object(name));
+    }
+
+    QVector<TraceFile*> files;
+    s >> count;
+    for (int i = 0; i < count && s.status() == QDataStream::Ok; i++) {
+        QString name;
+        s >> name;
+        files.append(d->file(name));
+    }
+
+    QVector<TraceFunction*> functions;
+    s >> count;
+    for (int i = 0; i < count && s.status() == QDataStream::Ok; i++) {
+        QString name;
+        qint32 file, object;
+        s >> name >> file >> object;
+        TraceFunction* f = d->function(name, cacheItem(files, file),
+                                       cacheItem(objects, object));
+        if (!f) return false;
+        functions.append(f);
+    }
+
+    QVector<TraceFunctionSource*> sources;
+    s >> count;
+    for (int i = 0; i < count && s.status() == QDataStream::Ok; i++) {
+        qint32 function, file;
+        s >> function >> file;
+        TraceFunction* f = cacheItem(functions, function);
+        TraceFile* sf = cacheItem(files, file);
+        if (!f || !sf) return false;
+        sources.append(f->sourceFile(sf, true));
+    }
+
+    FixPool* pool = d->fixPool();
+    QVector<SubCost> costs;
+    qint32 partCount;
+    s >> partCount;
+    for (int p = 0; p < partCount && s.status() == QDataStream::Ok; p++) {
+        QString name, descr, trigger, timeframe, version;
+        qint32 number, tid, pid;
+        QStringList events;
+        s >> name >> descr >> trigger >> timeframe >> version
+          >> number >> tid >> pid >> events;
+        if (!readCosts(s, costs) || costs.count() != events.count())
+            return false;
+
+        // owned by <d> from here on, also if reading fails
+        TracePart* part = new TracePart(d);
+        part->setName(name);
+        part->setDescription(descr);
+        part->setTrigger(trigger);
+        part->setTimeframe(timeframe);
+        part->setVersion(version);
+        if (number > 0) part->setPartNumber(number);
+        part->setThreadID(tid);
+        part->setProcessID(pid);
+        EventTypeMapping* m = d->eventTypes()->createMapping(events.join(' '));
+        part->setEventMapping(m);
+        d->addPart(part);
+        QVector<SubCost> totals = costs;
+
+        s >> count;
+        for (int i = 0; i < count && s.status() == QDataStream::Ok; i++) {
+            qint32 function, file, object, n;
+            s >> function >> file >> object;
+            TraceFunction* f = cacheItem(functions, function);
+            TraceFile* pfile = cacheItem(files, file);
+            TraceObject* pobject = cacheItem(objects, object);
+            if (!f || !pfile) return false;
+            TracePartFunction* pf;
+            pf = f->partFunction(part, pfile->partFile(part),
+                                 pobject ? pobject->partObject(part) : nullptr);
+
+            s >> n;
+            for (int j = 0; j < n && s.status() == QDataStream::Ok; j++) {
+                qint32 source;
+                quint32 fromLine, toLine;
+                quint64 fromAddr, toAddr;
+                s >> source >> fromLine >> toLine >> fromAddr >> toAddr;
+                if (!readCosts(s, costs)) return false;
+                TraceFunctionSource* fs = cacheItem(sources, source);
+                if (!fs) return false;
+                PositionSpec pos(fromLine, toLine, Addr(fromAddr), Addr(toAddr));
+                new (pool) FixCost(part, pool, fs, pos,
+                                   pf, costs.count(), costs.constData());
+            }
+
+            s >> n;
+            for (int j = 0; j < n && s.status() == QDataStream::Ok; j++) {
+                quint32 line, targetLine;
+                quint64 addr, targetAddr, executed, followed;
+                qint32 source, targetFunction, targetSource;
+                bool isCondJump;
+                s >> line >> addr >> source >> targetLine >> targetAddr
+                  >> targetFunction >> targetSource >> isCondJump
+                  >> executed >> followed;
+                TraceFunctionSource* fs = cacheItem(sources, source);
+                TraceFunction* tf = cacheItem(functions, targetFunction);
+                TraceFunctionSource* tfs = cacheItem(sources, targetSource);
+                if (!fs || !tf || !tfs) return false;
+                new (pool) FixJump(part, pool, line, Addr(addr), pf, fs,
+                                   targetLine, Addr(targetAddr), tf, tfs,
+                                   isCondJump, executed, followed);
+            }
+        }
+
+        s >> count;
+        for (int i = 0; i < count && s.status() == QDataStream::Ok; i++) {
+            qint32 caller, called, n;
+            s >> caller >> called;
+            TraceFunction* callerF = cacheItem(functions, caller);
+            TraceFunction* calledF = cacheItem(functions, called);
+            if (!callerF || !calledF) return false;
+            TracePartFunction* callerPF;
+            TracePartFunction* calledPF;
+            callerPF = (TracePartFunction*) callerF->findDepFromPart(part);
+            calledPF = (TracePartFunction*) calledF->findDepFromPart(part);
+            if (!callerPF || !calledPF) return false;
+            TracePartCall* pc;
+            pc = callerF->calling(calledF)->partCall(part, callerPF, calledPF);
+
+            s >> n;
+            for (int j = 0; j < n && s.status() == QDataStream::Ok; j++) {
+                qint32 source;
+                quint32 line;
+                quint64 addr, callCount;
+                s >> source >> line >> addr >> callCount;
+                if (!readCosts(s, costs)) return false;
+                TraceFunctionSource* fs = cacheItem(sources, source);
+                if (!fs) return false;
+                FixCallCost* fcc;
+                fcc = new (pool) FixCallCost(part, pool, fs,
+                                             line, Addr(addr), pc, callCount,
+                                             costs.count(), costs.constData());
+                fcc->setMax(d->callMax());
+                d->updateMaxCallCount(fcc->callCount());
+            }
+        }
+
+        part->invalidate();
+        part->totals()->clear();
+        for (int i = 0; i < m->count(); i++)
+            part->totals()->addCost(m->realIndex(i), totals[i]);
+    }
+
+    return s.status() == QDataStream::Ok;
+}
+
+
+int ProfileCache::load(TraceData* data, const QString& filename,
+                       Logger* logger)
+{
+    qint64 size, mtime;
+    QByteArray hash;
+    if (!profileKey(filename, size, mtime, hash)) return 0;
+
+    QFile file(cacheName(filename));
+    if (!file.open(QIODevice::ReadOnly)) return 0;
+
+    // read directly from the mapping if possible
+    uchar* mapped = file.map(0, file.size());
+    QByteArray bytes;
+    if (mapped)
+        bytes = QByteArray::fromRawData((const char*) mapped, file.size());
+    else
+        bytes = file.readAll();
+
+    QDataStream s(bytes);
+    s.setVersion(QDataStream::Qt_6_5);
+    quint32 magic, version;
+    qint64 cacheSize, cacheMtime;
+    QByteArray cacheHash;
+    s >> magic >> version >> cacheSize >> cacheMtime >> cacheHash;
+    if ((s.status() != QDataStream::Ok) ||
+        (magic != CACHE_MAGIC) || (version != CACHE_VERSION) ||
+        (cacheSize != size) || (cacheMtime != mtime) || (cacheHash != hash)) {
+        if (mapped) file.unmap(mapped);
+        return 0;
+    }
+
+    if (logger) logger->loadStart(filename);
+
+    // read into separate data first: an inconsistent cache must not
+    // leave partially loaded parts in <data>
+    TraceData* cached = new TraceData();
+    cached->setNumberParts(false);
+    bool ok = readCache(s, cached);
+    int partsLoaded = cached->parts().count();
+    if (ok) data->merge(cached);
+    delete cached;
+
+    if (mapped) file.unmap(mapped);
+
+    // on failure, the caller falls back to parsing the profile data file,
+    // which reports loading again
+    if (!ok) return 0;
+
+    if (logger) logger->loadFinished(QString());
+    return partsLoaded;
+}
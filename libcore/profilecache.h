@@ -0,0 +1,53 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-FileCopyrightText: 2026 KCachegrind Authors
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Binary cache of loaded profile data
+ */
+
+#ifndef PROFILECACHE_H
+#define PROFILECACHE_H
+
+#include <QString>
+
+#include "tracedata.h"
+
+class Logger;
+
+/**
+ * A cache file stores the parts loaded from a profile data file,
+ * with all names and fix cost items. It is put next to the profile
+ * file as hidden file, and is valid as long as size, modification
+ * time and a hash over start and end of the profile file match.
+ *
+ * Reading a cache avoids the text parsing on reopening big files.
+ */
+class ProfileCache
+{
+public:
+    // name of the cache file for profile data file @p filename
+    static QString cacheName(const QString& filename);
+
+    /**
+     * Load parts from cache of profile data file @p filename into @p data.
+     * Returns the number of parts loaded, 0 if no valid cache exists.
+     */
+    static int load(TraceData* data, const QString& filename,
+                    Logger* logger = nullptr);
+
+    /**
+     * Write cache for profile data file @p filename, containing @p parts
+     * of @p data which were loaded from that file.
+     * Returns false if the cache could not be written, also for
+     * parts with detailed costs still to be loaded.
+     */
+    static bool save(TraceData* data, const TracePartList& parts,
+                     const QString& filename);
+};
+
+#endif // PROFILECACHE_H
@@ -9,6 +9,8 @@
 
 #include "tracedata.h"
 
+#include <algorithm>
+
 #include <errno.h>
 #include <stdlib.h>
 
@@ -16,12 +18,22 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QDebug>
+#include <QHash>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QElapsedTimer>
 
 #include "logger.h"
 #include "loader.h"
 #include "globalconfig.h"
 #include "utils.h"
 #include "fixcost.h"
+#include "profilecache.h"
+#include "compresseddevice.h"
+#include "costcolumns.h"
+#include "nameindex.h"
 
 
 #define TRACE_DEBUG      0
@@ -165,6 +177,93 @@ void TraceInclusiveCost::addInclusive(ProfileCostArray* c)
 }
 
 
+//---------------------------------------------------
+// TracePoolItem
+
+template<ProfileContext::Type T>
+void* TracePoolItem<T>::operator new(size_t size, TraceData* data)
+{
+    return data->itemPool(T)->allocate(size);
+}
+
+
+//---------------------------------------------------
+// Dependency lists
+//
+// Dependencies of list cost items are kept sorted by the index of their
+// part. Most items only have a few dependencies (one per part), which
+// are searched directly. Longer lists get the part indexes in a
+// parallel vector: finding the dependency of a part is a binary search,
+// and update() checks for active parts in the bit set of TraceData
+// without touching the dependency itself.
+
+// minimal number of dependencies for a part index vector
+#define DEPPARTS_MINDEPS 8
+
+static inline int depPartIndex(CostItem* dep)
+{
+    TracePart* part = dep->part();
+    return part ? part->index() : -1;
+}
+
+// part index of dependency <i>
+template<class T>
+static inline int depPart(const QList<T*>& deps, const QVector<int>& depParts,
+                          int i)
+{
+    return depParts.isEmpty() ? depPartIndex(deps.at(i)) : depParts.at(i);
+}
+
+template<class T>
+static void insertDep(QList<T*>& deps, QVector<int>& depParts, T* dep)
+{
+    int index = depPartIndex(dep);
+
+    if (depParts.isEmpty()) {
+        if (deps.count() + 1 < DEPPARTS_MINDEPS) {
+            // loaders add dependencies in order of parts: usually append
+            int pos = deps.count();
+            while ((pos > 0) && (depPartIndex(deps.at(pos-1)) > index))
+                pos--;
+            deps.insert(pos, dep);
+            return;
+        }
+
+        depParts.reserve(deps.count() + 1);
+        for (int i = 0; i < deps.count(); i++)
+            depParts.append(depPartIndex(deps.at(i)));
+    }
+
+    int pos = depParts.count();
+    if ((pos > 0) && (depParts.at(pos-1) > index))
+        pos = std::upper_bound(depParts.constBegin(), depParts.constEnd(),
+                               index) - depParts.constBegin();
+
+    deps.insert(pos, dep);
+    depParts.insert(pos, index);
+}
+
+template<class T>
+static T* findDep(const QList<T*>& deps, const QVector<int>& depParts,
+                  TracePart* part)
+{
+    if (depParts.isEmpty()) {
+        for (T* dep : deps)
+            if (dep->part() == part) return dep;
+        return nullptr;
+    }
+
+    int index = part ? part->index() : -1;
+    QVector<int>::const_iterator it;
+    it = std::lower_bound(depParts.constBegin(), depParts.constEnd(), index);
+    for(; (it != depParts.constEnd()) && (*it == index); ++it) {
+        T* dep = deps.at(it - depParts.constBegin());
+        if (dep->part() == part) return dep;
+    }
+    return nullptr;
+}
+
+
 //---------------------------------------------------
 // TraceListCost
 
@@ -187,7 +286,7 @@ void TraceListCost::addDep(ProfileCostArray* dep)
     }
 #endif
 
-    _deps.append(dep);
+    insertDep(_deps, _depParts, dep);
     _lastDep = dep;
     invalidate();
 
@@ -203,13 +302,20 @@ ProfileCostArray* TraceListCost::findDepFromPart(TracePart* part)
     if (_lastDep && _lastDep->part() == part)
         return _lastDep;
 
-    foreach(ProfileCostArray* dep, _deps) {
-        if (dep->part() == part) {
-            _lastDep = dep;
-            return dep;
-        }
-    }
-    return nullptr;
+    ProfileCostArray* dep = findDep(_deps, _depParts, part);
+    if (dep) _lastDep = dep;
+    return dep;
+}
+
+TraceCostList TraceListCost::takeDeps()
+{
+    TraceCostList deps = _deps;
+    _deps.clear();
+    _depParts.clear();
+    _lastDep = nullptr;
+    invalidate();
+
+    return deps;
 }
 
 
@@ -223,11 +329,11 @@ void TraceListCost::update()
 #endif
 
     clear();
-    foreach(ProfileCostArray* item, _deps) {
-        if (onlyActiveParts())
-            if (!item->part() || !item->part()->isActive()) continue;
+    TraceData* d = onlyActiveParts() ? data() : nullptr;
+    for (int i = 0; i < _deps.count(); i++) {
+        if (d && !d->isPartActive(depPart(_deps, _depParts, i))) continue;
 
-        addCost(item);
+        addCost(_deps.at(i));
     }
 
     _dirty = false;
@@ -261,7 +367,7 @@ void TraceJumpListCost::addDep(TraceJumpCost* dep)
     }
 #endif
 
-    _deps.append(dep);
+    insertDep(_deps, _depParts, dep);
     _lastDep = dep;
     invalidate();
 
@@ -277,13 +383,9 @@ TraceJumpCost* TraceJumpListCost::findDepFromPart(TracePart* part)
     if (_lastDep && _lastDep->part() == part)
         return _lastDep;
 
-    foreach(TraceJumpCost* dep, _deps) {
-        if (dep->part() == part) {
-            _lastDep = dep;
-            return dep;
-        }
-    }
-    return nullptr;
+    TraceJumpCost* dep = findDep(_deps, _depParts, part);
+    if (dep) _lastDep = dep;
+    return dep;
 }
 
 
@@ -297,11 +399,11 @@ void TraceJumpListCost::update()
 #endif
 
     clear();
-    foreach(TraceJumpCost* item, _deps) {
-        if (onlyActiveParts())
-            if (!item->part() || !item->part()->isActive()) continue;
+    TraceData* d = onlyActiveParts() ? data() : nullptr;
+    for (int i = 0; i < _deps.count(); i++) {
+        if (d && !d->isPartActive(depPart(_deps, _depParts, i))) continue;
 
-        addCost(item);
+        addCost(_deps.at(i));
     }
 
     _dirty = false;
@@ -335,7 +437,7 @@ void TraceCallListCost::addDep(TraceCallCost* dep)
     }
 #endif
 
-    _deps.append(dep);
+    insertDep(_deps, _depParts, dep);
     _lastDep = dep;
     invalidate();
 
@@ -351,13 +453,26 @@ TraceCallCost* TraceCallListCost::findDepFromPart(TracePart* part)
     if (_lastDep && _lastDep->part() == part)
         return _lastDep;
 
-    foreach(TraceCallCost* dep, _deps) {
-        if (dep->part() == part) {
-            _lastDep = dep;
-            return dep;
-        }
-    }
-    return nullptr;
+    TraceCallCost* dep = findDep(_deps, _depParts, part);
+    if (dep) _lastDep = dep;
+    return dep;
+}
+
+void TraceCallListCost::squeezeDeps()
+{
+    _deps.squeeze();
+    _depParts.squeeze();
+}
+
+TraceCallCostList TraceCallListCost::takeDeps()
+{
+    TraceCallCostList deps = _deps;
+    _deps.clear();
+    _depParts.clear();
+    _lastDep = nullptr;
+    invalidate();
+
+    return deps;
 }
 
 
@@ -374,10 +489,11 @@ void TraceCallListCost::update()
      * i.e. do not change cost */
     if (_deps.count()>0) {
         clear();
-        foreach(TraceCallCost* item, _deps) {
-            if (onlyActiveParts())
-                if (!item->part() || !item->part()->isActive()) continue;
+        TraceData* d = onlyActiveParts() ? data() : nullptr;
+        for (int i = 0; i < _deps.count(); i++) {
+            if (d && !d->isPartActive(depPart(_deps, _depParts, i))) continue;
 
+            TraceCallCost* item = _deps.at(i);
             addCost(item);
             addCallCount(item->callCount());
         }
@@ -394,14 +510,30 @@ void TraceCallListCost::update()
 //---------------------------------------------------
 // TraceInclusiveListCost
 
+// Cumulative self and inclusive costs of the dependencies of a
+// TraceInclusiveListCost, in order of part index: row k holds the sums
+// over the first k dependencies, with one entry per real event type.
+class DepPrefixSums
+{
+public:
+    int realCount;
+    QVector<uint64> self, inclusive;
+};
+
+// minimal number of dependencies for building prefix sums
+#define PREFIXSUMS_MINDEPS 32
+
 TraceInclusiveListCost::TraceInclusiveListCost(ProfileContext* context)
     : TraceInclusiveCost(context)
 {
     _lastDep = nullptr;
+    _prefixSums = nullptr;
 }
 
 TraceInclusiveListCost::~TraceInclusiveListCost()
-{}
+{
+    delete _prefixSums;
+}
 
 
 void TraceInclusiveListCost::addDep(TraceInclusiveCost* dep)
@@ -414,8 +546,10 @@ void TraceInclusiveListCost::addDep(TraceInclusiveCost* dep)
     }
 #endif
 
-    _deps.append(dep);
+    insertDep(_deps, _depParts, dep);
     _lastDep = dep;
+    delete _prefixSums;
+    _prefixSums = nullptr;
     invalidate();
 
 #if TRACE_DEBUG
@@ -430,13 +564,88 @@ TraceInclusiveCost* TraceInclusiveListCost::findDepFromPart(TracePart* part)
     if (_lastDep && _lastDep->part() == part)
         return _lastDep;
 
-    foreach(TraceInclusiveCost* dep, _deps) {
-        if (dep->part() == part) {
-            _lastDep = dep;
-            return dep;
+    TraceInclusiveCost* dep = findDep(_deps, _depParts, part);
+    if (dep) _lastDep = dep;
+    return dep;
+}
+
+void TraceInclusiveListCost::squeezeDeps()
+{
+    _deps.squeeze();
+    _depParts.squeeze();
+}
+
+TraceInclusiveCostList TraceInclusiveListCost::takeDeps()
+{
+    TraceInclusiveCostList deps = _deps;
+    _deps.clear();
+    _depParts.clear();
+    _lastDep = nullptr;
+    delete _prefixSums;
+    _prefixSums = nullptr;
+    invalidate();
+
+    return deps;
+}
+
+bool TraceInclusiveListCost::addActiveRange()
+{
+    if (!GlobalConfig::partPrefixSums() ||
+        (_deps.count() < PREFIXSUMS_MINDEPS)) return false;
+
+    TraceData* d = data();
+    int first, last;
+    if (!d || !d->activeIndexRange(first, last)) return false;
+
+    if (!_prefixSums) {
+        // costs of dependencies do not change after loading
+        QList<ProfileCostArray*> self, inclusive;
+        foreach(TraceInclusiveCost* dep, _deps) {
+            self.append(dep);
+            inclusive.append(dep->inclusive());
+        }
+
+        int realCount = d->eventTypes()->realCount();
+        CostColumns columns;
+        _prefixSums = new DepPrefixSums;
+        _prefixSums->realCount = realCount;
+        for(int incl = 0; incl < 2; incl++) {
+            columns.set(incl ? inclusive : self, realCount);
+            QVector<uint64>& sums = incl ? _prefixSums->inclusive : _prefixSums->self;
+            sums.fill(0, (_deps.count() + 1) * realCount);
+            uint64* row = sums.data();
+            for(int r = 0; r < realCount; r++) {
+                const uint64* c = columns.column(r);
+                for(int k = 0; k < _deps.count(); k++)
+                    row[(k+1) * realCount + r] = row[k * realCount + r] + c[k];
+            }
         }
     }
-    return nullptr;
+
+    // dependencies with part index in [first, last]
+    // (with PREFIXSUMS_MINDEPS >= DEPPARTS_MINDEPS, _depParts is set up)
+    int k1 = std::lower_bound(_depParts.constBegin(), _depParts.constEnd(),
+                              first) - _depParts.constBegin();
+    int k2 = std::upper_bound(_depParts.constBegin(), _depParts.constEnd(),
+                              last) - _depParts.constBegin();
+
+    int realCount = _prefixSums->realCount;
+    const uint64* self = _prefixSums->self.constData();
+    const uint64* incl = _prefixSums->inclusive.constData();
+    for(int r = 0; r < realCount; r++) {
+        addCost(r, self[k2 * realCount + r] - self[k1 * realCount + r]);
+        _inclusive.addCost(r, incl[k2 * realCount + r] - incl[k1 * realCount + r]);
+    }
+    return true;
+}
+
+void TraceInclusiveListCost::updateDep(TraceInclusiveCost* dep, bool active)
+{
+    // a dirty item is recalculated from all dependencies anyway
+    if (_dirty) return;
+
+    addCostDelta(dep, !active);
+    _inclusive.addCostDelta(dep->inclusive(), !active);
 }
 
 void TraceInclusiveListCost::update()
@@ -449,12 +658,16 @@ void TraceInclusiveListCost::update()
 #endif
 
     clear();
-    foreach(TraceInclusiveCost* item, _deps) {
-        if (onlyActiveParts())
-            if (!item->part() || !item->part()->isActive()) continue;
+    bool onlyActive = onlyActiveParts();
+    if (!onlyActive || !addActiveRange()) {
+        TraceData* d = onlyActive ? data() : nullptr;
+        for (int i = 0; i < _deps.count(); i++) {
+            if (d && !d->isPartActive(depPart(_deps, _depParts, i))) continue;
 
-        addCost(item);
-        addInclusive(item->inclusive());
+            TraceInclusiveCost* item = _deps.at(i);
+            addCost(item);
+            addInclusive(item->inclusive());
+        }
     }
 
     _dirty = false;
@@ -949,7 +1162,7 @@ TracePartInstrJump* TraceInstrJump::partInstrJump(TracePart* part)
         if (item->part() == part)
             return item;
 
-    item = new TracePartInstrJump(this, _first);
+    item = new (part->data()) TracePartInstrJump(this, _first);
     item->setPosition(part);
     _first = item;
     return item;
@@ -1008,7 +1221,7 @@ TracePartLineJump* TraceLineJump::partLineJump(TracePart* part)
 {
     TracePartLineJump* item = (TracePartLineJump*) findDepFromPart(part);
     if (!item) {
-        item = new TracePartLineJump(this);
+        item = new (part->data()) TracePartLineJump(this);
         item->setPosition(part);
         addDep(item);
     }
@@ -1046,7 +1259,7 @@ TracePartInstrCall* TraceInstrCall::partInstrCall(TracePart* part,
 {
     TracePartInstrCall* item = (TracePartInstrCall*) findDepFromPart(part);
     if (!item) {
-        item = new TracePartInstrCall(this);
+        item = new (part->data()) TracePartInstrCall(this);
         item->setPosition(part);
         addDep(item);
         // instruction calls are not registered in function calls
@@ -1086,7 +1299,7 @@ TracePartLineCall* TraceLineCall::partLineCall(TracePart* part,
 {
     TracePartLineCall* item = (TracePartLineCall*) findDepFromPart(part);
     if (!item) {
-        item = new TracePartLineCall(this);
+        item = new (part->data()) TracePartLineCall(this);
         item->setPosition(part);
         addDep(item);
         partCall->addDep(item);
@@ -1125,7 +1338,7 @@ TracePartCall* TraceCall::partCall(TracePart* part,
 {
     TracePartCall* item = (TracePartCall*) findDepFromPart(part);
     if (!item) {
-        item = new TracePartCall(this);
+        item = new (part->data()) TracePartCall(this);
         item->setPosition(part);
         addDep(item);
         partCaller->addPartCalling(item);
@@ -1140,7 +1353,7 @@ TraceInstrCall* TraceCall::instrCall(TraceInstr* i)
         if (icall->instr() == i)
             return icall;
 
-    TraceInstrCall* icall = new TraceInstrCall(this, i);
+    TraceInstrCall* icall = new (_caller->data()) TraceInstrCall(this, i);
     _instrCalls.append(icall);
     invalidate();
 
@@ -1158,7 +1371,7 @@ TraceLineCall* TraceCall::lineCall(TraceLine* l)
         if (lcall->line() == l)
             return lcall;
 
-    TraceLineCall* lcall = new TraceLineCall(this, l);
+    TraceLineCall* lcall = new (_caller->data()) TraceLineCall(this, l);
     _lineCalls.append(lcall);
     invalidate();
 
@@ -1309,7 +1522,7 @@ TracePartInstr* TraceInstr::partInstr(TracePart* part,
 {
     TracePartInstr* item = (TracePartInstr*) findDepFromPart(part);
     if (!item) {
-        item = new TracePartInstr(this);
+        item = new (part->data()) TracePartInstr(this);
         item->setPosition(part);
         addDep(item);
         //part->addDep(item);
@@ -1324,7 +1537,8 @@ TraceInstrJump* TraceInstr::instrJump(TraceInstr* to, bool isJmpCond)
         if (jump->instrTo() == to)
             return jump;
 
-    TraceInstrJump* jump = new TraceInstrJump(this, to, isJmpCond);
+    TraceData* d = _function->data();
+    TraceInstrJump* jump = new (d) TraceInstrJump(this, to, isJmpCond);
     _instrJumps.append(jump);
     return jump;
 }
@@ -1402,7 +1616,7 @@ TracePartLine* TraceLine::partLine(TracePart* part,
 {
     TracePartLine* item = (TracePartLine*) findDepFromPart(part);
     if (!item) {
-        item = new TracePartLine(this);
+        item = new (part->data()) TracePartLine(this);
         item->setPosition(part);
         addDep(item);
 #if !USE_FIXCOST
@@ -1419,7 +1633,8 @@ TraceLineJump* TraceLine::lineJump(TraceLine* to, bool isJmpCond)
         if (jump->lineTo() == to)
             return jump;
 
-    TraceLineJump* jump = new TraceLineJump(this, to, isJmpCond);
+    TraceData* d = _sourceFile->function()->data();
+    TraceLineJump* jump = new (d) TraceLineJump(this, to, isJmpCond);
     _lineJumps.append(jump);
     return jump;
 }
@@ -1625,6 +1840,8 @@ TraceLineMap* TraceFunctionSource::lineMap()
      */
     foreach(TraceInclusiveCost* ic, _function->deps()) {
         TracePartFunction* pf = (TracePartFunction*) ic;
+        // parts loaded as summary only get detail now
+        pf->part()->loadDetail(pf);
 
         if (0) qDebug("PartFunction %s:%d",
                       qPrintable(pf->function()->name()),
@@ -1763,18 +1980,16 @@ bool TraceAssociation::setFunction(TraceFunction* f)
 
 void TraceAssociation::clear(TraceData* d, int rtti)
 {
-    TraceFunctionMap::Iterator it;
-    for ( it = d->functionMap().begin();
-          it != d->functionMap().end(); ++it )
-        (*it).removeAssociation(rtti);
+    TraceFunctionMap& functions = d->functionMap();
+    for (int i = 0; i < functions.count(); i++)
+        functions.at(i).removeAssociation(rtti);
 }
 
 void TraceAssociation::invalidate(TraceData* d, int rtti)
 {
-    TraceFunctionMap::Iterator it;
-    for ( it = d->functionMap().begin();
-          it != d->functionMap().end(); ++it )
-        (*it).invalidateAssociation(rtti);
+    TraceFunctionMap& functions = d->functionMap();
+    for (int i = 0; i < functions.count(); i++)
+        functions.at(i).invalidateAssociation(rtti);
 }
 
 
@@ -1796,6 +2011,8 @@ TraceFunction::TraceFunction()
 
     _instrMap = nullptr;
     _instrMapFilled = false;
+
+    _cycleIndex = -1;
 }
 
 
@@ -2137,14 +2354,31 @@ void TraceFunction::addCaller(TraceCall* caller)
 
 
 
+// lists up to this length are searched linearly, longer ones get a hash
+#define INDEX_MINITEMS 16
+
 TraceCall* TraceFunction::calling(TraceFunction* called)
 {
-    foreach(TraceCall* calling, _callings)
-        if (calling->called() == called)
-            return calling;
+    if (_callings.count() < INDEX_MINITEMS) {
+        foreach(TraceCall* calling, _callings)
+            if (calling->called() == called)
+                return calling;
+    }
+    else {
+        // lazy build of the index for functions calling many others
+        if (_callingIndex.isEmpty()) {
+            _callingIndex.reserve(2 * _callings.count());
+            foreach(TraceCall* calling, _callings)
+                _callingIndex.insert(calling->called(), calling);
+        }
+        TraceCall* calling = _callingIndex.value(called, nullptr);
+        if (calling) return calling;
+    }
 
-    TraceCall* calling = new TraceCall(this, called);
+    TraceCall* calling = new (data()) TraceCall(this, called);
     _callings.append(calling);
+    if (!_callingIndex.isEmpty())
+        _callingIndex.insert(called, calling);
 
     // we have to invalidate ourself so invalidations from item propagate up
     invalidate();
@@ -2161,14 +2395,28 @@ TraceFunctionSource* TraceFunction::sourceFile(TraceFile* file,
 {
     if (!file) file = _file;
 
-    foreach(TraceFunctionSource* sourceFile, _sourceFiles)
-        if (sourceFile->file() == file)
-            return sourceFile;
+    if (_sourceFiles.count() < INDEX_MINITEMS) {
+        foreach(TraceFunctionSource* sourceFile, _sourceFiles)
+            if (sourceFile->file() == file)
+                return sourceFile;
+    }
+    else {
+        // lazy build of the index, e.g. for functions with much inlining
+        if (_sourceFileIndex.isEmpty()) {
+            _sourceFileIndex.reserve(2 * _sourceFiles.count());
+            foreach(TraceFunctionSource* sourceFile, _sourceFiles)
+                _sourceFileIndex.insert(sourceFile->file(), sourceFile);
+        }
+        TraceFunctionSource* sourceFile = _sourceFileIndex.value(file, nullptr);
+        if (sourceFile) return sourceFile;
+    }
 
     if (!createNew) return nullptr;
 
     TraceFunctionSource* sourceFile = new TraceFunctionSource(this, file);
     _sourceFiles.append(sourceFile);
+    if (!_sourceFileIndex.isEmpty())
+        _sourceFileIndex.insert(file, sourceFile);
 
     // we have to invalidate ourself so invalidations from item propagate up
     invalidate();
@@ -2200,7 +2448,8 @@ TracePartFunction* TraceFunction::partFunction(TracePart* part,
 {
     TracePartFunction* item = (TracePartFunction*) findDepFromPart(part);
     if (!item) {
-        item = new TracePartFunction(this, partObject, partFile);
+        item = new (part->data()) TracePartFunction(this, partObject,
+                                                     partFile);
         item->setPosition(part);
         addDep(item);
 #if USE_FIXCOST
@@ -2294,6 +2543,34 @@ const TraceCallList& TraceFunction::callings(bool /* skipCycle */) const
     return _callings;
 }
 
+void TraceFunction::squeeze()
+{
+    _callers.squeeze();
+    _callings.squeeze();
+    foreach(TraceCall* c, _callings)
+        c->squeezeDeps();
+    squeezeDeps();
+}
+
+void TraceFunction::invalidatePartCost(TracePartFunction* pf)
+{
+    // calls of other parts keep their cost
+    foreach(TracePartCall* pc, pf->partCallings())
+        pc->call()->invalidateDynamicCost();
+
+    foreach(TraceFunctionSource* sf, _sourceFiles)
+        sf->invalidateDynamicCost();
+
+    if (_instrMap) {
+        TraceInstrMap::Iterator iit;
+        for ( iit = _instrMap->begin();
+              iit != _instrMap->end(); ++iit )
+            (*iit).invalidate();
+    }
+
+    invalidate();
+}
+
 void TraceFunction::invalidateDynamicCost()
 {
     foreach(TraceCall* c, _callings)
@@ -2346,11 +2623,15 @@ void TraceFunction::update()
 
     if (data()->inFunctionCycleUpdate() || !_cycle) {
         // usual case (no cycle member)
-        foreach(TraceInclusiveCost* item, _deps) {
-            if (!item->part() || !item->part()->isActive()) continue;
+        if (!addActiveRange()) {
+            TraceData* d = data();
+            for (int i = 0; i < _deps.count(); i++) {
+                if (!d->isPartActive(depPart(_deps, _depParts, i))) continue;
 
-            addCost(item);
-            addInclusive(item->inclusive());
+                TraceInclusiveCost* item = _deps.at(i);
+                addCost(item);
+                addInclusive(item->inclusive());
+            }
         }
     }
     else {
@@ -2373,10 +2654,11 @@ void TraceFunction::update()
         }
         else {
             // cycle member
-            foreach(TraceInclusiveCost* item, _deps) {
-                if (!item->part() || !item->part()->isActive()) continue;
+            TraceData* d = data();
+            for (int i = 0; i < _deps.count(); i++) {
+                if (!d->isPartActive(depPart(_deps, _depParts, i))) continue;
 
-                addCost(item);
+                addCost(_deps.at(i));
             }
             _dirty = false; // do not recurse
             addInclusive(this);
@@ -2402,32 +2684,16 @@ bool TraceFunction::isCycleMember()
 void TraceFunction::cycleReset()
 {
     _cycle = nullptr;
-    _cycleStackDown = nullptr;
-    _cycleLow = 0;
+    _cycleIndex = -1;
 }
 
-// this does not mark functions calling themself !
-void TraceFunction::cycleDFS(int d, int& pNo, TraceFunction** pTop)
+/* cycle cut heuristic:
+ * skip calls for cycle detection if they make less than _cycleCut
+ * percent of the cost of the function.
+ * FIXME: Which cost type to use for this heuristic ?!
+ */
+SubCost TraceFunction::cycleCutLimit(EventType* e)
 {
-    if (_cycleLow != 0) return;
-
-    // initialize with prefix order
-    pNo++;
-    int prefixNo = pNo;
-    _cycleLow = prefixNo;
-
-    // put myself on stack
-    _cycleStackDown = *pTop;
-    *pTop = this;
-
-    /* cycle cut heuristic:
-     * skip calls for cycle detection if they make less than _cycleCut
-     * percent of the cost of the function.
-     * FIXME: Which cost type to use for this heuristic ?!
-     */
-    Q_ASSERT((data() != nullptr) && (data()->eventTypes()->realCount()>0));
-    EventType* e = data()->eventTypes()->realType(0);
-
     SubCost base = 0;
     if (_callers.count()>0) {
         foreach(TraceCall* caller, _callers)
@@ -2436,75 +2702,7 @@ void TraceFunction::cycleDFS(int d, int& pNo, TraceFunction** pTop)
     }
     else base = inclusive()->subCost(e);
 
-    SubCost cutLimit = SubCost(base * GlobalConfig::cycleCut());
-
-    if (0) {
-        qDebug("%s (%d) Visiting %s",
-               qPrintable(QString().fill(' ', d)),
-               pNo, qPrintable(prettyName()));
-        qDebug("%s       Cum. %s, Max Caller %s, cut limit %s",
-               qPrintable(QString().fill(' ', d)),
-               qPrintable(inclusive()->subCost(e).pretty()),
-               qPrintable(base.pretty()),
-               qPrintable(cutLimit.pretty()));
-    }
-
-    foreach(TraceCall *callee, _callings) {
-        TraceFunction* called = callee->called();
-
-        // cycle cut heuristic
-        if (callee->subCost(e) < cutLimit) {
-            if (0) qDebug("%s       Cut call to %s (cum. %s)",
-                          qPrintable(QString().fill(' ', d)),
-                          qPrintable(called->prettyName()),
-                          qPrintable(callee->subCost(e).pretty()));
-
-            continue;
-        }
-
-        if (called->_cycleLow==0) {
-            // not visited yet
-            called->cycleDFS(d+1, pNo, pTop);
-            if (called->_cycleLow < _cycleLow)
-                _cycleLow = called->_cycleLow;
-        }
-        else if (called->_cycleStackDown) {
-            // backlink to same SCC (still in stack)
-            if (called->_cycleLow < _cycleLow)
-                _cycleLow = called->_cycleLow;
-
-            if (0) qDebug("%s (low %d) Back to %s",
-                          qPrintable(QString().fill(' ', d)),
-                          _cycleLow, qPrintable(called->prettyName()));
-        }
-    }
-
-    if (prefixNo == _cycleLow) {
-        // this is the base of a SCC.
-
-        if (*pTop == this) {
-            *pTop = _cycleStackDown;
-            _cycleStackDown = nullptr;
-        }
-        else {
-            // a SCC with >1 members
-
-            TraceFunctionCycle* cycle = data()->functionCycle(this);
-            if (0) qDebug("Found Cycle %d with base %s:",
-                          cycle->cycleNo(), qPrintable(prettyName()));
-            while(*pTop) {
-                TraceFunction* top = *pTop;
-                cycle->add(top);
-
-                // remove from stack
-                *pTop = top->_cycleStackDown;
-                top->_cycleStackDown = nullptr;
-
-                if (0) qDebug("  %s", qPrintable(top->prettyName()));
-                if (top == this) break;
-            }
-        }
-    }
+    return SubCost(base * GlobalConfig::cycleCut());
 }
 
 
@@ -2525,6 +2723,8 @@ TraceInstrMap* TraceFunction::instrMap()
 
     foreach(TraceInclusiveCost* icost, deps()) {
         TracePartFunction* pf = (TracePartFunction*) icost;
+        // parts loaded as summary only get detail now
+        pf->part()->loadDetail(pf);
 
         if (0) qDebug("PartFunction %s:%d",
                       qPrintable(pf->function()->name()),
@@ -2651,6 +2851,7 @@ void TraceFunctionCycle::init()
     _callers.clear();
     // this deletes all TraceCall's to members
     _callings.clear();
+    _callingIndex.clear();
 
     invalidate();
 }
@@ -2673,7 +2874,7 @@ void TraceFunctionCycle::setup()
         }
 
         // the cycle has a call to each member
-        TraceCall* call = new TraceCall(this, f);
+        TraceCall* call = new (data()) TraceCall(this, f);
         call->invalidate();
         _callings.append(call);
 
@@ -2713,7 +2914,7 @@ TracePartClass* TraceClass::partClass(TracePart* part)
 {
     TracePartClass* item = (TracePartClass*) findDepFromPart(part);
     if (!item) {
-        item = new TracePartClass(this);
+        item = new (part->data()) TracePartClass(this);
         item->setPosition(part);
         addDep(item);
     }
@@ -2761,7 +2962,7 @@ TracePartFile* TraceFile::partFile(TracePart* part)
 {
     TracePartFile* item = (TracePartFile*) findDepFromPart(part);
     if (!item) {
-        item = new TracePartFile(this);
+        item = new (part->data()) TracePartFile(this);
         item->setPosition(part);
         addDep(item);
     }
@@ -2885,7 +3086,7 @@ TracePartObject* TraceObject::partObject(TracePart* part)
 {
     TracePartObject* item = (TracePartObject*) findDepFromPart(part);
     if (!item) {
-        item = new TracePartObject(this);
+        item = new (part->data()) TracePartObject(this);
         item->setPosition(part);
         addDep(item);
     }
@@ -2972,15 +3173,37 @@ TracePart::TracePart(TraceData* data)
     _dep = data;
     _active = true;
     _number = 0;
+    _index = data ? data->newPartIndex() : -1;
     _tid = 0;
     _pid = 0;
 
     _eventTypeMapping = nullptr;
+    _detailSource = nullptr;
 }
 
 TracePart::~TracePart()
 {
+    // a part deleted while loading must not break the active range
+    if (data()) data()->setPartActive(_index, false);
     delete _eventTypeMapping;
+    delete _detailSource;
+}
+
+void TracePart::setDetailSource(DetailSource* d)
+{
+    if (_detailSource == d) return;
+
+    delete _detailSource;
+    _detailSource = d;
+}
+
+void TracePart::loadDetail(TracePartFunction* pf)
+{
+    if (!_detailSource || !_detailSource->pending(pf)) return;
+
+    if (!_detailSource->load(pf))
+        qWarning("Detailed costs of %s not loaded: %s changed",
+                 qPrintable(pf->function()->prettyName()), qPrintable(_name));
 }
 
 void TracePart::setPartNumber(int n)
@@ -3027,6 +3250,7 @@ bool TracePart::activate(bool active)
 {
     if (_active == active) return false;
     _active = active;
+    if (data()) data()->setPartActive(_index, active);
 
     // to be done by the client of this function
     //  data()->invalidateDynamicCost();
@@ -3065,11 +3289,23 @@ void TraceData::init()
 {
     _functionCycleCount = 0;
     _inFunctionCycleUpdate = false;
+    _functionCycleTime = 0;
 
     _maxThreadID = 0;
     _maxPartNumber = 0;
+    _activeFirst = _activeLast = -1;
+    _activeRangeDirty = true;
+    _numberParts = true;
+    _follow = false;
+    _loadCanceled.storeRelaxed(0);
+    _loadParent = nullptr;
+    _loadThreads = 0;
     _fixPool = nullptr;
     _dynPool = nullptr;
+    _namePool = nullptr;
+    _functionNameIndex = nullptr;
+    for (int t = 0; t < ProfileContext::MaxType; t++)
+        _itemPools[t] = nullptr;
 
     _arch = ArchUnknown;
 }
@@ -3078,8 +3314,18 @@ TraceData::~TraceData()
 {
     qDeleteAll(_parts);
 
+    // cost items in the item pools are destructed with their owners
+    _functionMap.clear();
+    _fileMap.clear();
+    _classMap.clear();
+    _objectMap.clear();
+    for (int t = 0; t < ProfileContext::MaxType; t++)
+        delete _itemPools[t];
+
     delete _fixPool;
     delete _dynPool;
+    delete _namePool;
+    delete _functionNameIndex;
 }
 
 QString TraceData::shortTraceName() const
@@ -3099,6 +3345,14 @@ FixPool* TraceData::fixPool()
     return _fixPool;
 }
 
+FixPool* TraceData::itemPool(ProfileContext::Type t)
+{
+    if (!_itemPools[t])
+        _itemPools[t] = new FixPool();
+
+    return _itemPools[t];
+}
+
 DynPool* TraceData::dynPool()
 {
     if (!_dynPool)
@@ -3107,6 +3361,59 @@ DynPool* TraceData::dynPool()
     return _dynPool;
 }
 
+NamePool* TraceData::namePool()
+{
+    if (!_namePool)
+        _namePool = new NamePool();
+
+    return _namePool;
+}
+
+void TraceData::releaseNames()
+{
+    delete _namePool;
+    _namePool = nullptr;
+
+    _objectById = QVector<TraceObject*>();
+    _fileById = QVector<TraceFile*>();
+    _functionById = QHash<TraceFunctionKey, TraceFunction*>();
+}
+
+bool TraceData::functionCandidates(const QString& pattern,
+                                   TraceFunctionList& list)
+{
+    list.clear();
+
+    // functions are only added, by loading more files
+    if (!_functionNameIndex ||
+        (_functionNameIndex->count() != _functionMap.count())) {
+        if (!_functionNameIndex)
+            _functionNameIndex = new NameIndex();
+        _functionNameIndex->clear();
+        _functionNameIndexItems.clear();
+        _functionNameIndexItems.reserve(_functionMap.count());
+        // ids in order of names, as used when iterating the map
+        TraceFunctionMap::Iterator it;
+        for ( it = _functionMap.begin(); it != _functionMap.end(); ++it ) {
+            TraceFunction* f = &(*it);
+            // the name shown for functions without name can be searched
+            _functionNameIndex->add(_functionNameIndexItems.count(),
+                                    f->name().isEmpty() ?
+                                    TraceFunction::prettyEmptyName() : f->name());
+            _functionNameIndexItems.append(f);
+        }
+        _functionNameIndex->finish();
+    }
+
+    QVector<int> ids;
+    if (!_functionNameIndex->candidates(pattern, ids)) return false;
+
+    list.reserve(ids.count());
+    foreach(int i, ids)
+        list.append(_functionNameIndexItems.at(i));
+    return true;
+}
+
 bool partLessThan(const TracePart* p1, const TracePart* p2)
 {
     return *p1 < *p2;
@@ -3145,15 +3452,25 @@ int TraceData::load(QStringList files)
         return 0;
     }
 
-    QStringList::const_iterator it;
+    int threads = GlobalConfig::loadThreads();
+    if (threads <= 0) threads = QThread::idealThreadCount();
+
     int partsLoaded = 0;
-    for (it = files.constBegin(); it != files.constEnd(); ++it ) {
-        QFile file(*it);
-        partsLoaded += internalLoad(&file, *it);
+    if ((files.count() > 1) && (threads > 1) && !_follow) {
+        partsLoaded = parallelLoad(files, threads);
     }
-    if (partsLoaded == 0) return 0;
+    else {
+        QStringList::const_iterator it;
+        for (it = files.constBegin(); it != files.constEnd(); ++it ) {
+            if (loadCanceled()) break;
+            QFile file(*it);
+            partsLoaded += internalLoad(&file, *it);
+        }
+    }
+    if ((partsLoaded == 0) || loadCanceled()) return 0;
 
     std::sort(_parts.begin(), _parts.end(), partLessThan);
+    freeze();
     invalidateDynamicCost();
     updateFunctionCycles();
 
@@ -3169,13 +3486,30 @@ int TraceData::load(QIODevice* file, const QString& filename)
 {
     _traceName = filename;
     int partsLoaded = internalLoad(file, filename);
+    if (loadCanceled()) return 0;
     if (partsLoaded>0) {
+        freeze();
         invalidateDynamicCost();
         updateFunctionCycles();
     }
     return partsLoaded;
 }
 
+int TraceData::loadThreads() const
+{
+    if (_loadThreads > 0) return _loadThreads;
+
+    int threads = GlobalConfig::loadThreads();
+    if (threads <= 0) threads = QThread::idealThreadCount();
+    return threads;
+}
+
+bool TraceData::loadCanceled() const
+{
+    if (_loadCanceled.loadRelaxed()) return true;
+    return _loadParent && _loadParent->loadCanceled();
+}
+
 int TraceData::internalLoad(QIODevice* device, const QString& filename)
 {
     if (!device->open( QIODevice::ReadOnly ) ) {
@@ -3190,53 +3524,432 @@ int TraceData::internalLoad(QIODevice* device, const QString& filename)
         if (device->size() == 0) return 0;
 
         _logger->loadStart(filename);
-        _logger->loadFinished(QStringLiteral("Unknown file format"));
+        CompressedDevice::Compression c = CompressedDevice::compression(device);
+        if ((c != CompressedDevice::None) && !CompressedDevice::isSupported(c))
+            _logger->loadFinished(QStringLiteral("Compression format not supported"));
+        else
+            _logger->loadFinished(QStringLiteral("Unknown file format"));
         return 0;
     }
-    l->setLogger(_logger);
+    if (_follow)
+        return l->loadAppended(this, device, filename,
+                               _followed[filename], _logger);
+
+    // a valid cache next to a profile data file avoids parsing.
+    // It always has all events, so is not used with an event selection
+    bool useCache = GlobalConfig::useLoadCache() &&
+                    GlobalConfig::loadEvents().isEmpty() &&
+                    (dynamic_cast<QFile*>(device) != nullptr);
+    if (useCache) {
+        int partsLoaded = ProfileCache::load(this, filename, _logger);
+        if (partsLoaded > 0) return partsLoaded;
+    }
+
+    // pass our logger with the call: loaders are shared among threads
+    int partsBefore = _parts.count();
+    int partsLoaded = l->load(this, device, filename, _logger);
+    if (useCache && (partsLoaded > 0) && !loadCanceled())
+        ProfileCache::save(this, _parts.mid(partsBefore), filename);
+
+    return partsLoaded;
+}
 
-    int partsLoaded = l->load(this, device, filename);
 
-    l->setLogger(nullptr);
+int TraceData::loadAppended()
+{
+    int partsLoaded = 0;
+    QMap<QString, LoaderPosition>::Iterator it;
+    for (it = _followed.begin(); it != _followed.end(); ++it) {
+        QFile file(it.key());
+        // quick check without parsing anything
+        if (QFileInfo(it.key()).size() <= it.value().offset) continue;
+        if (!file.open( QIODevice::ReadOnly )) continue;
+
+        Loader* l = Loader::matchingLoader(&file);
+        if (l)
+            partsLoaded += l->loadAppended(this, &file, it.key(),
+                                           it.value(), _logger);
+    }
+    if (partsLoaded == 0) return 0;
+
+    std::sort(_parts.begin(), _parts.end(), partLessThan);
+    releaseNames();
+    invalidateDynamicCost();
+    updateFunctionCycles();
 
     return partsLoaded;
 }
 
+
+/**
+ * Load each file into its own TraceData in a thread pool, and
+ * merge the results in file order, i.e. resulting parts and
+ * part numbering are the same as with sequential loading.
+ *
+ * Loggers of the worker threads are created here in the main
+ * thread and forwarded after all loaders are finished.
+ */
+int TraceData::parallelLoad(const QStringList& files, int threads)
+{
+    int count = files.count();
+    QList<TraceData*> loaded;
+    QList<BufferedLogger*> messages;
+    QVector<int> partsLoaded(count, 0);
+    QAtomicInt done = 0;
+
+    for (int i = 0; i < count; i++) {
+        BufferedLogger* m = new BufferedLogger;
+        TraceData* d = new TraceData(m);
+        d->setNumberParts(false);
+        d->setLoadParent(this);
+        // files are loaded in parallel already: share the threads
+        d->setLoadThreads(qMax(1, threads / count));
+        messages.append(m);
+        loaded.append(d);
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    int* partsLoadedPtr = partsLoaded.data();
+    for (int i = 0; i < count; i++) {
+        TraceData* d = loaded[i];
+        QString filename = files[i];
+        int* parts = partsLoadedPtr + i;
+        pool.start([d, filename, parts, &done]() {
+            if (!d->loadCanceled()) {
+                QFile file(filename);
+                *parts = d->internalLoad(&file, filename);
+            }
+            done.ref();
+        });
+    }
+
+    if (_logger) _logger->loadStart(_traceName);
+    while (!pool.waitForDone(100)) {
+        if (_logger) _logger->loadProgress(100 * done.loadRelaxed() / count);
+    }
+
+    int partsSum = 0;
+    for (int i = 0; i < count; i++) {
+        messages[i]->forward(_logger);
+        if ((partsLoaded[i] > 0) && !loadCanceled()) {
+            merge(loaded[i]);
+            partsSum += partsLoaded[i];
+        }
+        delete loaded[i];
+        delete messages[i];
+    }
+
+    return partsSum;
+}
+
+void TraceData::merge(TraceData* other, TracePart* into)
+{
+    // parts first: fix costs need the event type mapping of this data
+    EventTypeSet* otherSet = other->eventTypes();
+    foreach(TracePart* part, other->_parts) {
+        if (into) break;
+
+        EventTypeMapping* om = part->eventTypeMapping();
+        if (om) {
+            QStringList names;
+            QVector<SubCost> totals(om->count());
+            for (int i = 0; i < om->count(); i++) {
+                EventType* t = otherSet->realType(om->realIndex(i));
+                names << t->name();
+                totals[i] = part->totals()->subCost(t);
+            }
+            EventTypeMapping* m = _eventTypes.createMapping(names.join(' '));
+            // detail loaded on demand must skip the same columns
+            m->copySkipped(om);
+            part->totals()->clear();
+            for (int i = 0; i < m->count(); i++)
+                part->totals()->addCost(m->realIndex(i), totals[i]);
+            part->setEventMapping(m);
+            delete om;
+        }
+
+        part->setPosition(this);
+        part->setDependent(this);
+        // dependencies get sorted by the new index when moved below
+        part->setIndex(newPartIndex());
+        setPartActive(part->index(), part->isActive());
+        if (part->partNumber() > 0)
+            part->setPartNumber(part->partNumber());
+        part->setThreadID(part->threadID());
+        part->invalidate();
+        addPart(part);
+    }
+    // when fusing, the parts of other are deleted with other
+    if (!into)
+        other->_parts.clear();
+
+    // map cost items of other by name
+    QHash<TraceObject*, TraceObject*> objectMap;
+    QHash<TraceFile*, TraceFile*> fileMap;
+    QHash<TraceClass*, TraceClass*> classMap;
+    QHash<TraceFunction*, TraceFunction*> functionMap;
+    QHash<TraceFunctionSource*, TraceFunctionSource*> sourceMap;
+
+    // order of items does not matter here
+    for (int i = 0; i < other->_objectMap.count(); i++) {
+        TraceObject* oo = &other->_objectMap.at(i);
+        objectMap.insert(oo, object(oo->name()));
+    }
+
+    for (int i = 0; i < other->_fileMap.count(); i++) {
+        TraceFile* ofl = &other->_fileMap.at(i);
+        fileMap.insert(ofl, file(ofl->name()));
+    }
+
+    for (int i = 0; i < other->_functionMap.count(); i++) {
+        TraceFunction* of = &other->_functionMap.at(i);
+        TraceFunction* f = function(of->name(),
+                                    fileMap.value(of->file()),
+                                    objectMap.value(of->object()));
+        functionMap.insert(of, f);
+        classMap.insert(of->cls(), f->cls());
+
+        foreach(TraceFunctionSource* os, of->sourceFiles())
+            sourceMap.insert(os, f->sourceFile(fileMap.value(os->file()), true));
+    }
+
+    // move part cost items over. When fusing, the part items of
+    // objects/files/classes are created by TraceFunction::partFunction()
+    if (!into) {
+        for (int i = 0; i < other->_objectMap.count(); i++) {
+            TraceObject* oo = &other->_objectMap.at(i);
+            TraceObject* o = objectMap.value(oo);
+            foreach(TraceInclusiveCost* dep, oo->takeDeps()) {
+                dep->setDependent(o);
+                o->addDep(dep);
+            }
+        }
+
+        for (int i = 0; i < other->_fileMap.count(); i++) {
+            TraceFile* ofl = &other->_fileMap.at(i);
+            TraceFile* f = fileMap.value(ofl);
+            foreach(TraceInclusiveCost* dep, ofl->takeDeps()) {
+                dep->setDependent(f);
+                f->addDep(dep);
+            }
+        }
+
+        for (int i = 0; i < other->_classMap.count(); i++) {
+            TraceClass* oc = &other->_classMap.at(i);
+            TraceClass* c = classMap.value(oc);
+            if (!c) continue;
+            foreach(TraceInclusiveCost* dep, oc->takeDeps()) {
+                dep->setDependent(c);
+                c->addDep(dep);
+            }
+        }
+    }
+
+    for (int i = 0; i < other->_functionMap.count(); i++) {
+        TraceFunction* of = &other->_functionMap.at(i);
+        TraceFunction* f = functionMap.value(of);
+
+        foreach(TraceInclusiveCost* dep, of->takeDeps()) {
+            TracePartFunction* opf = (TracePartFunction*) dep;
+            TracePartFunction* pf = opf;
+            if (into) {
+                TracePartObject* opo = opf->partObject();
+                TracePartObject* po = nullptr;
+                if (opo) po = objectMap.value(opo->object())->partObject(into);
+                TracePartFile* pfl;
+                pfl = fileMap.value(opf->partFile()->file())->partFile(into);
+                pf = f->partFunction(into, pfl, po);
+            }
+            else {
+                pf->setDependent(f);
+                f->addDep(pf);
+            }
+
+            FixCost* lastCost = nullptr;
+            for (FixCost* fc = opf->firstFixCost(); fc;
+                 fc = fc->nextCostOfPartFunction()) {
+                fc->setFunctionSource(sourceMap.value(fc->functionSource()));
+                if (into) fc->setPart(into);
+                lastCost = fc;
+            }
+            FixJump* lastJump = nullptr;
+            for (FixJump* fj = opf->firstFixJump(); fj;
+                 fj = fj->nextJumpOfPartFunction()) {
+                fj->setSources(sourceMap.value(fj->source()),
+                               functionMap.value(fj->targetFunction()),
+                               sourceMap.value(fj->targetSource()));
+                if (into) fj->setPart(into);
+                lastJump = fj;
+            }
+
+            if (pf != opf) {
+                // pending detail of a chunk goes to the fused part
+                DetailSource* od = opf->part()->detailSource();
+                if (od && od->pending(opf)) {
+                    if (!into->detailSource())
+                        into->setDetailSource(opf->part()->takeDetailSource());
+                    into->detailSource()->take(od, opf, pf);
+                }
+
+                // prepend fix cost lists of other to the fused item
+                if (lastCost)
+                    lastCost->setNextCostOfPartFunction(
+                        pf->setFirstFixCost(opf->firstFixCost()));
+                if (lastJump)
+                    lastJump->setNextJumpOfPartFunction(
+                        pf->setFirstFixJump(opf->firstFixJump()));
+                pf->invalidate();
+                delete opf;
+            }
+        }
+    }
+
+    // calls in a second pass: when fusing, part functions of
+    // called functions have to exist already
+    for (int i = 0; i < other->_functionMap.count(); i++) {
+        TraceFunction* of = &other->_functionMap.at(i);
+        TraceFunction* f = functionMap.value(of);
+
+        foreach(TraceCall* oc, of->callings()) {
+            TraceCall* c = f->calling(functionMap.value(oc->called()));
+            foreach(TraceCallCost* dep, oc->takeDeps()) {
+                TracePartCall* opc = (TracePartCall*) dep;
+                TracePartCall* pc = opc;
+                if (into) {
+                    TracePartFunction* caller;
+                    TracePartFunction* called;
+                    caller = (TracePartFunction*) f->findDepFromPart(into);
+                    called = (TracePartFunction*) c->called()->findDepFromPart(into);
+                    pc = c->partCall(into, caller, called);
+                }
+                else {
+                    pc->setDependent(c);
+                    c->addDep(pc);
+                }
+
+                FixCallCost* last = nullptr;
+                for (FixCallCost* fcc = opc->firstFixCallCost(); fcc;
+                     fcc = fcc->nextCostOfPartCall()) {
+                    fcc->setFunctionSource(sourceMap.value(fcc->functionSource()));
+                    if (into) fcc->setPart(into);
+                    fcc->setMax(&_callMax);
+                    updateMaxCallCount(fcc->callCount());
+                    last = fcc;
+                }
+
+                if (pc != opc) {
+                    if (last)
+                        last->setNextCostOfPartCall(
+                            pc->setFirstFixCallCost(opc->firstFixCallCost()));
+                    pc->invalidate();
+                    delete opc;
+                }
+            }
+        }
+    }
+
+    // fix costs and moved items stay where they are, just take over the memory
+    if (other->_fixPool)
+        fixPool()->merge(other->_fixPool);
+    for (int t = 0; t < ProfileContext::MaxType; t++)
+        if (other->_itemPools[t])
+            itemPool((ProfileContext::Type) t)->merge(other->_itemPools[t]);
+
+    if (!other->_command.isEmpty())
+        _command = other->_command;
+    if (other->_arch != ArchUnknown)
+        _arch = other->_arch;
+
+    if (into)
+        into->invalidate();
+    invalidate();
+}
+
+void TraceData::freeze()
+{
+    releaseNames();
+
+    for (int i = 0; i < _objectMap.count(); i++)
+        _objectMap.at(i).squeezeDeps();
+    for (int i = 0; i < _classMap.count(); i++)
+        _classMap.at(i).squeezeDeps();
+    for (int i = 0; i < _fileMap.count(); i++)
+        _fileMap.at(i).squeezeDeps();
+    for (int i = 0; i < _functionMap.count(); i++)
+        _functionMap.at(i).squeeze();
+}
+
 bool TraceData::activateParts(const TracePartList& l)
 {
-    bool changed = false;
+    TracePartList changed;
 
     foreach(TracePart* part, _parts)
         if (part->activate(l.contains(part)))
-            changed = true;
+            changed.append(part);
 
-    if (changed) {
-        // because active parts have changed, throw away calculated
-        // costs...
-        invalidateDynamicCost();
-        updateFunctionCycles();
-    }
+    if (!changed.isEmpty())
+        updateActiveParts(changed);
 
-    return changed;
+    return !changed.isEmpty();
 }
 
 
 bool TraceData::activateParts(TracePartList l, bool active)
 {
-    bool changed = false;
+    TracePartList changed;
 
     foreach(TracePart* part, l) {
         if (_parts.contains(part))
             if (part->activate(active))
-                changed = true;
+                changed.append(part);
     }
 
-    if (changed) {
+    if (!changed.isEmpty())
+        updateActiveParts(changed);
+
+    return !changed.isEmpty();
+}
+
+void TraceData::updateActiveParts(const TracePartList& parts)
+{
+    if (GlobalConfig::showCycles()) {
+        // cycles depend on costs of calls: because active parts
+        // have changed, throw away all calculated costs...
         invalidateDynamicCost();
         updateFunctionCycles();
+        return;
+    }
+
+    // Only items with cost in changed parts have to be updated.
+    // Objects, classes and files have cost in most parts: instead of
+    // summing up all parts again, add or subtract the changed ones.
+    foreach(TracePart* part, parts) {
+        bool active = part->isActive();
+        QSet<TracePartObject*> partObjects;
+        QSet<TracePartClass*> partClasses;
+        QSet<TracePartFile*> partFiles;
+
+        foreach(ProfileCostArray* dep, part->deps()) {
+            TracePartFunction* pf = (TracePartFunction*) dep;
+            pf->function()->invalidatePartCost(pf);
+
+            if (pf->partObject()) partObjects.insert(pf->partObject());
+            if (pf->partClass()) partClasses.insert(pf->partClass());
+            if (pf->partFile()) partFiles.insert(pf->partFile());
+        }
+
+        foreach(TracePartObject* po, partObjects)
+            po->object()->updateDep(po, active);
+        foreach(TracePartClass* pc, partClasses)
+            pc->cls()->updateDep(pc, active);
+        foreach(TracePartFile* pf, partFiles)
+            pf->file()->updateDep(pf, active);
     }
 
-    return changed;
+    invalidate();
+    // only resets cycle information, as cycles are not shown
+    updateFunctionCycles();
 }
 
 bool TraceData::activatePart(TracePart* p, bool active)
@@ -3253,7 +3966,8 @@ void TraceData::addPart(TracePart* part)
 {
     if (_parts.contains(part)>0) return;
 
-    if ((part->partNumber()==0) &&
+    if (_numberParts &&
+        (part->partNumber()==0) &&
         (part->processID()==0)) {
         _maxPartNumber++;
         part->setPartNumber(_maxPartNumber);
@@ -3261,6 +3975,44 @@ void TraceData::addPart(TracePart* part)
     _parts.append(part);
 }
 
+int TraceData::newPartIndex()
+{
+    int index = _activeParts.size();
+    _activeParts.resize(index + 1);
+    _activeParts.setBit(index);
+    _activeRangeDirty = true;
+    return index;
+}
+
+void TraceData::setPartActive(int index, bool active)
+{
+    if ((index < 0) || (index >= _activeParts.size())) return;
+    _activeParts.setBit(index, active);
+    _activeRangeDirty = true;
+}
+
+bool TraceData::activeIndexRange(int& first, int& last)
+{
+    if (_activeRangeDirty) {
+        int count = _activeParts.size();
+        int f = 0, l = count - 1;
+        while ((f < count) && !_activeParts.testBit(f)) f++;
+        while ((l >= f) && !_activeParts.testBit(l)) l--;
+
+        // contiguous if there is no inactive part in between
+        _activeFirst = _activeLast = -1;
+        if ((f <= l) && (_activeParts.count(true) == l - f + 1)) {
+            _activeFirst = f;
+            _activeLast = l;
+        }
+        _activeRangeDirty = false;
+    }
+
+    first = _activeFirst;
+    last = _activeLast;
+    return _activeFirst >= 0;
+}
+
 TracePart* TraceData::partWithName(const QString& name)
 {
     foreach(TracePart* part, _parts)
@@ -3297,28 +4049,19 @@ QString TraceData::activePartRange()
 
 void TraceData::invalidateDynamicCost()
 {
-    // invalidate all dynamic costs
+    // invalidate all dynamic costs, order does not matter
 
-    TraceObjectMap::Iterator oit;
-    for ( oit = _objectMap.begin();
-          oit != _objectMap.end(); ++oit )
-        (*oit).invalidate();
+    for (int i = 0; i < _objectMap.count(); i++)
+        _objectMap.at(i).invalidate();
 
-    TraceClassMap::Iterator cit;
-    for ( cit = _classMap.begin();
-          cit != _classMap.end(); ++cit )
-        (*cit).invalidate();
+    for (int i = 0; i < _classMap.count(); i++)
+        _classMap.at(i).invalidate();
 
-    TraceFileMap::Iterator fit;
-    for ( fit = _fileMap.begin();
-          fit != _fileMap.end(); ++fit )
-        (*fit).invalidate();
+    for (int i = 0; i < _fileMap.count(); i++)
+        _fileMap.at(i).invalidate();
 
-    TraceFunctionMap::Iterator it;
-    for ( it = _functionMap.begin();
-          it != _functionMap.end(); ++it ) {
-        (*it).invalidateDynamicCost();
-    }
+    for (int i = 0; i < _functionMap.count(); i++)
+        _functionMap.at(i).invalidateDynamicCost();
 
     invalidate();
 
@@ -3435,18 +4178,14 @@ TraceFunction* TraceData::function(const QString& name,
     // The change was motivated by bug ID 3014067 (on SourceForge).
     QString key = name + file->shortName() + object->shortName();
 
-    TraceFunctionMap::Iterator it;
-    it = _functionMap.find(key);
-    if (it == _functionMap.end()) {
-        it = _functionMap.insert(key, TraceFunction());
-        TraceFunction& f = it.value();
-
+    TraceFunction& f = _functionMap[key];
+    if (!f.data()) {
+        // was created
         f.setPosition(this);
         f.setName(name);
         f.setClass(c);
         f.setObject(object);
         f.setFile(file);
-        //f.setMapIterator(it);
 
 #if TRACE_DEBUG
         qDebug("Created %s [TraceData::function]\n  for %s, %s, %s",
@@ -3460,7 +4199,49 @@ TraceFunction* TraceData::function(const QString& name,
         file->addFunction(&f);
     }
 
-    return &(it.value());
+    return &f;
+}
+
+TraceObject* TraceData::objectById(int nameId)
+{
+    if (_objectById.size() <= nameId)
+        _objectById.resize(namePool()->count());
+
+    TraceObject* o = _objectById.at(nameId);
+    if (!o) {
+        o = object(QString::fromLocal8Bit(_namePool->name(nameId),
+                                          _namePool->length(nameId)));
+        _objectById[nameId] = o;
+    }
+    return o;
+}
+
+TraceFile* TraceData::fileById(int nameId)
+{
+    if (_fileById.size() <= nameId)
+        _fileById.resize(namePool()->count());
+
+    TraceFile* f = _fileById.at(nameId);
+    if (!f) {
+        f = file(QString::fromLocal8Bit(_namePool->name(nameId),
+                                        _namePool->length(nameId)));
+        _fileById[nameId] = f;
+    }
+    return f;
+}
+
+TraceFunction* TraceData::functionById(int nameId,
+                                       TraceFile* file, TraceObject* object)
+{
+    TraceFunctionKey key = { nameId, file, object };
+    TraceFunction* f = _functionById.value(key);
+    if (!f) {
+        f = function(QString::fromLocal8Bit(namePool()->name(nameId),
+                                            _namePool->length(nameId)),
+                     file, object);
+        if (f) _functionById.insert(key, f);
+    }
+    return f;
 }
 
 TraceFunctionMap::Iterator TraceData::functionIterator(TraceFunction* f)
@@ -3495,10 +4276,102 @@ void TraceData::updateMaxCallCount(SubCost c)
 
 void TraceData::resetSourceDirs()
 {
-    TraceFileMap::Iterator fit;
-    for ( fit = _fileMap.begin();
-          fit != _fileMap.end(); ++fit )
-        (*fit).resetDirectory();
+    for (int i = 0; i < _fileMap.count(); i++)
+        _fileMap.at(i).resetDirectory();
+}
+
+// minimal number of items per thread in updateAll()
+#define PARALLEL_MINITEMS 256
+
+// Call @p work for ranges of [0, @p count), in a pool of @p threads.
+// Each index is in exactly one range.
+template<class F>
+static void parallelRanges(int count, int threads, const F& work)
+{
+    int chunks = qMin(threads * 4, count / PARALLEL_MINITEMS);
+    if ((threads <= 1) || (chunks <= 1)) {
+        work(0, count);
+        return;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    int size = (count + chunks - 1) / chunks;
+    for (int start = 0; start < count; start += size) {
+        int end = qMin(start + size, count);
+        pool.start([&work, start, end]() { work(start, end); });
+    }
+    pool.waitForDone();
+}
+
+// Update calls from functions (not from cycles, which depend on cycle
+// members), with their part calls. As reading an event type through
+// subCost() writes the value cache of an item, the value of the first
+// real event type is cached here, so that later reads by functions
+// only hit the cache.
+void TraceData::updateCalls(int threads)
+{
+    EventType* e = _eventTypes.realType(0);
+    // the active range is computed lazily, not while threads read it
+    int first, last;
+    activeIndexRange(first, last);
+
+    parallelRanges(_functionMap.count(), threads, [this, e](int start, int end) {
+        for (int i = start; i < end; i++) {
+            foreach(TraceCall* call, _functionMap.at(i).callings()) {
+                call->update();
+                if (!e) continue;
+                call->subCost(e);
+                foreach(TraceCallCost* pc, call->deps())
+                    pc->subCost(e);
+            }
+        }
+    });
+}
+
+void TraceData::updateAll(int threads)
+{
+    if (threads <= 0) threads = GlobalConfig::loadThreads();
+    if (threads <= 0) threads = QThread::idealThreadCount();
+
+    // Items are updated in phases. In each phase, every item updated
+    // belongs to exactly one range, and items only read from items
+    // updated in an earlier phase.
+
+    // 1. calls
+    updateCalls(threads);
+
+    // 2. part functions, and functions not in a cycle
+    parallelRanges(_functionMap.count(), threads, [this](int start, int end) {
+        for (int i = start; i < end; i++) {
+            TraceFunction& f = _functionMap.at(i);
+            foreach(TraceInclusiveCost* pf, f.deps())
+                pf->inclusive();
+            if (!f.cycle()) f.update();
+        }
+    });
+
+    // 3. objects, classes and files, with their part items
+    QVector<TraceInclusiveListCost*> groups;
+    groups.reserve(_objectMap.count() + _classMap.count() + _fileMap.count());
+    for (int i = 0; i < _objectMap.count(); i++)
+        groups.append(&_objectMap.at(i));
+    for (int i = 0; i < _classMap.count(); i++)
+        groups.append(&_classMap.at(i));
+    for (int i = 0; i < _fileMap.count(); i++)
+        groups.append(&_fileMap.at(i));
+    parallelRanges(groups.count(), threads, [&groups](int start, int end) {
+        for (int i = start; i < end; i++)
+            groups.at(i)->update();
+    });
+
+    // 4. cycles and their members depend on each other
+    foreach(TraceFunctionCycle* cycle, _functionCycles)
+        cycle->update();
+    for (int i = 0; i < _functionMap.count(); i++)
+        _functionMap.at(i).update();
+
+    update();
 }
 
 void TraceData::update()
@@ -3673,6 +4546,8 @@ TraceFunctionCycle* TraceData::functionCycle(TraceFunction* f)
 void TraceData::updateFunctionCycles()
 {
     //qDebug("Updating cycles...");
+    QElapsedTimer timer;
+    timer.start();
 
     // init cycle info
     foreach(TraceFunctionCycle* cycle, _functionCycles)
@@ -3682,35 +4557,108 @@ void TraceData::updateFunctionCycles()
     for ( it = _functionMap.begin(); it != _functionMap.end(); ++it )
         (*it).cycleReset();
 
+    _functionCycleTime = 0;
     if (!GlobalConfig::showCycles()) return;
 
     _inFunctionCycleUpdate = true;
 
+    // costs of calls needed for the cycle cut heuristic, in parallel
+    int threads = GlobalConfig::loadThreads();
+    if (threads <= 0) threads = QThread::idealThreadCount();
+    updateCalls(threads);
 
-#if 0
-    int fCount = _functionMap.size(), fNo = 0, progress=0, p;
-    QString msg = tr("Recalculating Function Cycles...");
-    if (_topLevel) _topLevel->showStatus(msg,0);
-#endif
+    // Nodes are functions in order of names, as this is the order in
+    // which cycles are found and numbered.
+    int n = _functionMap.count();
+    QVector<TraceFunction*> nodes;
+    nodes.reserve(n);
+    for ( it = _functionMap.begin(); it != _functionMap.end(); ++it ) {
+        (*it).setCycleIndex(nodes.count());
+        nodes.append(&(*it));
+    }
 
-    // DFS and collapse strong connected components (Tarjan)
+    // Compact adjacency array with the calls not skipped by the cycle
+    // cut heuristic: node i calls edges[edgeStart[i]...edgeStart[i+1]-1]
+    Q_ASSERT(_eventTypes.realCount()>0);
+    EventType* e = _eventTypes.realType(0);
+    QVector<int> edgeStart(n + 1);
+    QVector<int> edges;
+    for (int i = 0; i < n; i++) {
+        edgeStart[i] = edges.count();
+        TraceFunction* f = nodes.at(i);
+        SubCost cutLimit = f->cycleCutLimit(e);
+        foreach(TraceCall* call, f->callings()) {
+            int w = call->called()->cycleIndex();
+            if ((w < 0) || (call->subCost(e) < cutLimit)) continue;
+            edges.append(w);
+        }
+    }
+    edgeStart[n] = edges.count();
+
+    // DFS and collapse strong connected components (Tarjan), with
+    // explicit stacks instead of recursion, as call chains can be deep.
+    // A node not visited yet has prefix number 0.
+    QVector<int> prefix(n, 0), low(n, 0);
+    QBitArray onStack(n);
+    QVector<int> stack;
+    // DFS path: nodes, and the next of their calls to visit
+    QVector<int> path, pathEdge;
     int pNo = 0;
-    TraceFunction* stackTop;
-    for ( it = _functionMap.begin(); it != _functionMap.end(); ++it ) {
+    for (int root = 0; root < n; root++) {
+        if (prefix.at(root) != 0) continue;
+
+        prefix[root] = low[root] = ++pNo;
+        stack.append(root);
+        onStack.setBit(root);
+        path.append(root);
+        pathEdge.append(edgeStart.at(root));
+
+        while(!path.isEmpty()) {
+            int v = path.last();
+            int edge = pathEdge.last();
+            if (edge < edgeStart.at(v + 1)) {
+                pathEdge.last() = edge + 1;
+                int w = edges.at(edge);
+                if (prefix.at(w) == 0) {
+                    // not visited yet
+                    prefix[w] = low[w] = ++pNo;
+                    stack.append(w);
+                    onStack.setBit(w);
+                    path.append(w);
+                    pathEdge.append(edgeStart.at(w));
+                }
+                else if (onStack.testBit(w)) {
+                    // backlink to same SCC (still in stack)
+                    if (low.at(w) < low.at(v)) low[v] = low.at(w);
+                }
+                continue;
+            }
 
-#if 0
-        if (_topLevel) {
-            fNo++;
-            p = 100*fNo/fCount;
-            if (p> progress) {
-                progress = p;
-                _topLevel->showStatus(msg, p);
+            // all calls of v visited
+            path.removeLast();
+            pathEdge.removeLast();
+            if (!path.isEmpty() && (low.at(v) < low.at(path.last())))
+                low[path.last()] = low.at(v);
+
+            if (prefix.at(v) != low.at(v)) continue;
+
+            // v is the base of a SCC.
+            if (stack.last() == v) {
+                // this does not mark functions calling themself !
+                stack.removeLast();
+                onStack.clearBit(v);
+                continue;
             }
-        }
-#endif
 
-        stackTop = nullptr;
-        (*it).cycleDFS(1, pNo, &stackTop);
+            // a SCC with >1 members
+            TraceFunctionCycle* cycle = functionCycle(nodes.at(v));
+            int w;
+            do {
+                w = stack.takeLast();
+                onStack.clearBit(w);
+                cycle->add(nodes.at(w));
+            } while(w != v);
+        }
     }
 
     // postprocess cycles
@@ -3721,9 +4669,9 @@ void TraceData::updateFunctionCycles()
     // we have to invalidate costs because cycles are now taken into account
     invalidateDynamicCost();
 
-#if 0
-    if (0) if (_topLevel) _topLevel->showStatus(QString(), 0);
-#endif
+    _functionCycleTime = (int) timer.elapsed();
+    if (0) qDebug("Cycle detection: %d functions, %d calls, %d ms",
+                  n, (int) edges.count(), _functionCycleTime);
 }
 
 void TraceData::updateObjectCycles()
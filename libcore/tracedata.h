@@ -18,6 +18,10 @@
 #include <qstring.h>
 #include <qstringlist.h>
 #include <qmap.h>
+#include <qhash.h>
+#include <qvector.h>
+#include <qatomic.h>
+#include <qbitarray.h>
 
 #include "costitem.h"
 #include "subcost.h"
@@ -25,6 +29,8 @@
 #include "addr.h"
 #include "context.h"
 #include "eventtype.h"
+#include "loader.h"
+#include "itemtable.h"
 
 class QFile;
 
@@ -113,6 +119,8 @@ class FixCallCost;
 class FixJump;
 class FixPool;
 class DynPool;
+class NamePool;
+class NameIndex;
 class Logger;
 
 class ProfileCostArray;
@@ -150,6 +158,7 @@ class TraceObject;
 class TraceFile;
 class TracePart;
 class TraceData;
+class DepPrefixSums;
 
 typedef QList<ProfileCostArray*> TraceCostList;
 typedef QList<TraceJumpCost*> TraceJumpCostList;
@@ -177,12 +186,31 @@ typedef QList<TraceLineRegion*> TraceLineRegionList;
 typedef QList<TraceFunctionSource*> TraceFunctionSourceList;
 typedef QList<TraceFunction*> TraceFunctionList;
 typedef QList<TraceFunctionCycle*> TraceFunctionCycleList;
-typedef QMap<QString, TraceObject> TraceObjectMap;
-typedef QMap<QString, TraceClass> TraceClassMap;
-typedef QMap<QString, TraceFile> TraceFileMap;
-typedef QMap<QString, TraceFunction> TraceFunctionMap;
-typedef QMap<uint, TraceLine> TraceLineMap;
-typedef QMap<Addr, TraceInstr> TraceInstrMap;
+typedef TraceItemTable<TraceObject> TraceObjectMap;
+typedef TraceItemTable<TraceClass> TraceClassMap;
+typedef TraceItemTable<TraceFile> TraceFileMap;
+typedef TraceItemTable<TraceFunction> TraceFunctionMap;
+typedef TraceKeyTable<uint, TraceLine> TraceLineMap;
+typedef TraceKeyTable<Addr, TraceInstr> TraceInstrMap;
+
+
+/**
+ * Base for cost items of the call graph which exist in large numbers.
+ *
+ * These are allocated with "new (data) Item(...)" from a pool of their
+ * TraceData, one pool per item type @p T (see TraceData::itemPool).
+ * Items of the same type are next to each other in memory, in order of
+ * creation. delete only runs the destructor: the memory is freed
+ * together with the TraceData, in large chunks.
+ */
+template<ProfileContext::Type T>
+class TracePoolItem
+{
+public:
+    void* operator new(size_t size, TraceData* data);
+    void operator delete(void*) {}
+    void operator delete(void*, TraceData*) {}
+};
 
 
 /**
@@ -273,12 +301,16 @@ public:
     TraceCostList& deps() { return _deps; }
     void addDep(ProfileCostArray*);
     ProfileCostArray* findDepFromPart(TracePart*);
+    // removes all dependencies, passing ownership to the caller
+    TraceCostList takeDeps();
 
 protected:
     // overwrite in subclass to change update behaviour
     virtual bool onlyActiveParts() { return false; }
 
     TraceCostList _deps;
+    // part indexes of _deps, sorted (only for long lists)
+    QVector<int> _depParts;
 
 private:
     // very temporary: cached
@@ -308,6 +340,8 @@ protected:
     virtual bool onlyActiveParts() { return false; }
 
     TraceJumpCostList _deps;
+    // part indexes of _deps, sorted (only for long lists)
+    QVector<int> _depParts;
 
 private:
     // very temporary: cached
@@ -333,12 +367,18 @@ public:
     TraceCallCostList deps() { return _deps; }
     void addDep(TraceCallCost*);
     TraceCallCost* findDepFromPart(TracePart*);
+    // removes all dependencies, passing ownership to the caller
+    TraceCallCostList takeDeps();
+    // release spare capacity of the dependency list
+    void squeezeDeps();
 
 protected:
     // overwrite in subclass to change update behaviour
     virtual bool onlyActiveParts() { return false; }
 
     TraceCallCostList _deps;
+    // part indexes of _deps, sorted (only for long lists)
+    QVector<int> _depParts;
 
 private:
     // very temporary: cached
@@ -361,16 +401,37 @@ public:
     TraceInclusiveCostList deps() { return _deps; }
     void addDep(TraceInclusiveCost*);
     TraceInclusiveCost* findDepFromPart(TracePart*);
+    // removes all dependencies, passing ownership to the caller
+    TraceInclusiveCostList takeDeps();
+    // release spare capacity of the dependency list
+    void squeezeDeps();
+    /* After the part of @p dep was activated or deactivated: add or
+     * subtract its cost if this item is up to date, instead of
+     * recalculating from all dependencies
+     */
+    void updateDep(TraceInclusiveCost* dep, bool active);
 
 protected:
     // overwrite in subclass to change update behaviour
     virtual bool onlyActiveParts() { return false; }
 
+    /* If the active parts are a contiguous range of part indexes
+     * (see TraceData::activeIndexRange), add self and inclusive cost of
+     * the dependencies in this range as difference of cumulative costs
+     * over all dependencies, built on first use.
+     * Returns false if not done, e.g. if switched off in GlobalConfig.
+     */
+    bool addActiveRange();
+
     TraceInclusiveCostList _deps;
+    // part indexes of _deps, sorted (only for long lists)
+    QVector<int> _depParts;
 
 private:
     // very temporary: cached
     TraceInclusiveCost* _lastDep;
+    // cumulative costs of _deps, see addActiveRange()
+    DepPrefixSums* _prefixSums;
 };
 
 
@@ -385,7 +446,8 @@ private:
 /**
  * Cost of jump at a instruction code address from a trace file.
  */
-class TracePartInstrJump: public TraceJumpCost
+class TracePartInstrJump: public TraceJumpCost,
+                          public TracePoolItem<ProfileContext::PartInstrJump>
 {
 public:
     TracePartInstrJump(TraceInstrJump*, TracePartInstrJump*);
@@ -406,7 +468,8 @@ private:
  * Cost of a call at a instruction code address from a trace file.
  * Cost is always up to date, no lazy update needed.
  */
-class TracePartInstrCall: public TraceCallCost
+class TracePartInstrCall: public TraceCallCost,
+                          public TracePoolItem<ProfileContext::PartInstrCall>
 {
 public:
     explicit TracePartInstrCall(TraceInstrCall*);
@@ -422,7 +485,8 @@ public:
  * Cost of a code instruction address from a trace file.
  * Cost is always up to date, no lazy update needed.
  */
-class TracePartInstr: public ProfileCostArray
+class TracePartInstr: public ProfileCostArray,
+                      public TracePoolItem<ProfileContext::PartInstr>
 {
 public:
     explicit TracePartInstr(TraceInstr*);
@@ -438,7 +502,8 @@ public:
 /**
  * Cost of jump at a source line from a trace file.
  */
-class TracePartLineJump: public TraceJumpCost
+class TracePartLineJump: public TraceJumpCost,
+                         public TracePoolItem<ProfileContext::PartLineJump>
 {
 public:
     explicit TracePartLineJump(TraceLineJump*);
@@ -454,7 +519,8 @@ public:
  * Cost of a call at a line from a trace file.
  * Cost is always up to date, no lazy update needed.
  */
-class TracePartLineCall: public TraceCallCost
+class TracePartLineCall: public TraceCallCost,
+                         public TracePoolItem<ProfileContext::PartLineCall>
 {
 public:
     explicit TracePartLineCall(TraceLineCall*);
@@ -471,7 +537,8 @@ public:
  * Cost of a line from a trace file.
  * Cost is always up to date, no lazy update needed.
  */
-class TracePartLine: public ProfileCostArray
+class TracePartLine: public ProfileCostArray,
+                     public TracePoolItem<ProfileContext::PartLine>
 {
 public:
     explicit TracePartLine(TraceLine*);
@@ -503,7 +570,8 @@ public:
  * Cost of a call at a function to another function,
  * from a single trace file.
  */
-class TracePartCall: public TraceCallListCost
+class TracePartCall: public TraceCallListCost,
+                     public TracePoolItem<ProfileContext::PartCall>
 {
 public:
     explicit TracePartCall(TraceCall* call);
@@ -530,7 +598,8 @@ private:
  * Cost of a function,
  * from a single trace file.
  */
-class TracePartFunction: public TraceInclusiveCost
+class TracePartFunction: public TraceInclusiveCost,
+                         public TracePoolItem<ProfileContext::PartFunction>
 {
 public:
     TracePartFunction(TraceFunction*,
@@ -594,7 +663,8 @@ private:
  * Cost of a class,
  * from a single trace file.
  */
-class TracePartClass: public TraceInclusiveListCost
+class TracePartClass: public TraceInclusiveListCost,
+                      public TracePoolItem<ProfileContext::PartClass>
 {
 public:
     explicit TracePartClass(TraceClass*);
@@ -611,7 +681,8 @@ public:
  * Cost of a source file,
  * from a single trace file.
  */
-class TracePartFile: public TraceInclusiveListCost
+class TracePartFile: public TraceInclusiveListCost,
+                     public TracePoolItem<ProfileContext::PartFile>
 {
 public:
     explicit TracePartFile(TraceFile*);
@@ -626,7 +697,8 @@ public:
  * Cost of a object,
  * from a single trace file.
  */
-class TracePartObject: public TraceInclusiveListCost
+class TracePartObject: public TraceInclusiveListCost,
+                       public TracePoolItem<ProfileContext::PartObject>
 {
 public:
     explicit TracePartObject(TraceObject*);
@@ -660,6 +732,8 @@ public:
     QString timeframe() const { return _timeframe; }
     QString version() const { return _version; }
     int partNumber() const { return _number; }
+    // dense index of this part in its TraceData, see TraceData::isPartActive()
+    int index() const { return _index; }
     int threadID() const { return _tid; }
     int processID() const { return _pid; }
     void setDescription(const QString& d) { _descr = d; }
@@ -668,6 +742,7 @@ public:
     void setVersion(const QString& v) { _version = v; }
     void setName(const QString& n) { _name = n; }
     void setPartNumber(int n);
+    void setIndex(int i) { _index = i; }
     void setThreadID(int t);
     void setProcessID(int p);
     ProfileCostArray* totals() { return &_totals; }
@@ -675,6 +750,15 @@ public:
     void setEventMapping(EventTypeMapping* sm) { _eventTypeMapping = sm; }
     EventTypeMapping* eventTypeMapping() { return _eventTypeMapping; }
 
+    /* for parts loaded with summary costs only: source of the
+     * detailed costs of part functions. Passes ownership */
+    void setDetailSource(DetailSource* d);
+    DetailSource* detailSource() const { return _detailSource; }
+    DetailSource* takeDetailSource()
+    { DetailSource* d = _detailSource; _detailSource = nullptr; return d; }
+    // make sure that detailed costs of @p pf are loaded
+    void loadDetail(TracePartFunction* pf);
+
     // returns true if something changed
     bool activate(bool);
     bool isActive() const { return _active; }
@@ -690,6 +774,7 @@ private:
     QString _version;
 
     int _number, _tid, _pid;
+    int _index;
 
     bool _active;
 
@@ -698,6 +783,8 @@ private:
 
     // event type mapping for all fix costs of this part
     EventTypeMapping* _eventTypeMapping;
+
+    DetailSource* _detailSource;
 };
 
 
@@ -711,7 +798,8 @@ private:
 /**
  * A jump from an instruction to another inside of a function
  */
-class TraceInstrJump: public TraceJumpCost
+class TraceInstrJump: public TraceJumpCost,
+                      public TracePoolItem<ProfileContext::InstrJump>
 {
 public:
     TraceInstrJump(TraceInstr* instrFrom, TraceInstr* instrTo,
@@ -740,7 +828,8 @@ private:
 /**
  * A jump from one line to another inside of a function.
  */
-class TraceLineJump: public TraceJumpListCost
+class TraceLineJump: public TraceJumpListCost,
+                     public TracePoolItem<ProfileContext::LineJump>
 {
 public:
     TraceLineJump(TraceLine* lineFrom, TraceLine* lineTo,
@@ -768,7 +857,8 @@ private:
 /**
  * A call from an instruction of one function to another function
  */
-class TraceInstrCall: public TraceCallListCost
+class TraceInstrCall: public TraceCallListCost,
+                      public TracePoolItem<ProfileContext::InstrCall>
 {
 public:
     TraceInstrCall(TraceCall* call, TraceInstr* instr);
@@ -794,7 +884,8 @@ private:
 /**
  * A call from a line of one function to another function.
  */
-class TraceLineCall: public TraceCallListCost
+class TraceLineCall: public TraceCallListCost,
+                     public TracePoolItem<ProfileContext::LineCall>
 {
 public:
     TraceLineCall(TraceCall* call, TraceLine* line);
@@ -821,7 +912,8 @@ private:
  * A call from one to another function.
  * Consists of a list a TraceLineCalls
  */
-class TraceCall: public TraceCallListCost
+class TraceCall: public TraceCallListCost,
+                 public TracePoolItem<ProfileContext::Call>
 {
 public:
     TraceCall(TraceFunction* caller, TraceFunction* called);
@@ -1121,6 +1213,10 @@ public:
     // this invalidate all subcosts of function depending on
     // active status of parts
     void invalidateDynamicCost();
+    // only items with cost from part function @p pf
+    void invalidatePartCost(TracePartFunction* pf);
+    // release spare capacity of dependency and call lists
+    void squeeze();
 
     void addCaller(TraceCall*);
 
@@ -1190,11 +1286,17 @@ public:
     bool isCycle();
     bool isCycleMember();
     void cycleReset();
-    void cycleDFS(int d, int& pNo, TraceFunction** pTop);
+    // node number in cycle detection
+    void setCycleIndex(int i) { _cycleIndex = i; }
+    int cycleIndex() const { return _cycleIndex; }
+    // calls with less cost are ignored in cycle detection
+    SubCost cycleCutLimit(EventType*);
 
 protected:
     TraceCallList _callers; // list of calls we are called from
     TraceCallList _callings; // list of calls we are calling (we are owner)
+    // index into _callings by called function, for long lists only
+    QHash<TraceFunction*, TraceCall*> _callingIndex;
     TraceFunctionCycle* _cycle;
 
 private:
@@ -1206,6 +1308,8 @@ private:
     TraceFile* _file;
 
     TraceFunctionSourceList _sourceFiles; // we are owner
+    // index into _sourceFiles by file, for long lists only
+    QHash<TraceFile*, TraceFunctionSource*> _sourceFileIndex;
     TraceInstrMap* _instrMap; // we are owner
     bool _instrMapFilled;
 
@@ -1213,8 +1317,7 @@ private:
     TraceAssociationList _associations;
 
     // for cycle detection
-    int _cycleLow;
-    TraceFunction* _cycleStackDown;
+    int _cycleIndex;
 
     // cached
     SubCost _calledCount, _callingCount;
@@ -1344,6 +1447,28 @@ private:
 
 
 
+/**
+ * Key of a function with name interned in the NamePool of TraceData
+ */
+struct TraceFunctionKey
+{
+    int name;
+    TraceFile* file;
+    TraceObject* object;
+};
+
+inline bool operator==(const TraceFunctionKey& k1, const TraceFunctionKey& k2)
+{
+    return (k1.name == k2.name) && (k1.file == k2.file) &&
+           (k1.object == k2.object);
+}
+
+inline size_t qHash(const TraceFunctionKey& k, size_t seed = 0)
+{
+    return qHash(k.name, seed) ^ (qHash(k.file, seed) * 31) ^
+           (qHash(k.object, seed) * 1000003);
+}
+
 /**
  * This class holds profiling data of multiple tracefiles
  * generated with cachegrind on one command.
@@ -1372,11 +1497,40 @@ public:
     int load(QString file);
     int load(QIODevice*, const QString&);
 
-    /** returns true if something changed. These do NOT
-     * invalidate the dynamic costs on a activation change,
-     * i.e. all cost items depends on active parts.
-     * This has to be done by the caller when true is returned by
-     * calling invalidateDynamicCost().
+    /**
+     * Follow mode for profile data files still written to: files loaded
+     * afterwards are remembered with the position reached, and
+     * loadAppended() only loads parts added since then.
+     * Has to be set before loading. Files are loaded one after the other.
+     */
+    void setFollow(bool f) { _follow = f; }
+    bool follow() const { return _follow; }
+    // load parts appended to followed files, returns number of new parts
+    int loadAppended();
+
+    /**
+     * Request to abort a load running in another thread. Loaders check
+     * for this from time to time and stop parsing, and load() returns 0.
+     * The data is incomplete afterwards and should be deleted.
+     */
+    void cancelLoad() { _loadCanceled.storeRelaxed(1); }
+    bool loadCanceled() const;
+    // data loaded as part of @p parent gets canceled together with it
+    void setLoadParent(TraceData* parent) { _loadParent = parent; }
+    /* Threads a loader may use for one file of this data. Default
+     * (0) is GlobalConfig::loadThreads(), or the number of cores.
+     */
+    void setLoadThreads(int threads) { _loadThreads = threads; }
+    int loadThreads() const;
+    // receiver of notifications, e.g. after loading in another thread
+    void setLogger(Logger* l) { _logger = l; }
+
+    /** returns true if something changed. activateParts() and
+     * activateAll() update the dynamic costs depending on active parts:
+     * sums over parts add or subtract the changed parts, and only items
+     * with cost in these parts are invalidated.
+     * activatePart() does NOT do this. The caller has to call
+     * invalidateDynamicCost() when true is returned.
      */
     bool activateParts(const TracePartList&);
     bool activateParts(TracePartList, bool active);
@@ -1386,6 +1540,37 @@ public:
     // to be used by loader
     void addPart(TracePart*);
 
+    /* Dense index for a new part, which is active. Parts get their
+     * index on creation, as dependencies of cost items are sorted by
+     * part index before the part is added with addPart().
+     */
+    int newPartIndex();
+    void setPartActive(int index, bool active);
+    bool isPartActive(int index) const
+    { return (index >= 0) && (index < _activeParts.size()) && _activeParts.testBit(index); }
+    /* Returns true if the active parts are exactly the parts with index
+     * in [@p first, @p last], e.g. for a time range of dumps selected.
+     */
+    bool activeIndexRange(int& first, int& last);
+
+    /**
+     * Moves all parts loaded into @p other over to this data,
+     * appending them to the existing parts. Objects, files and
+     * functions are matched by name. Afterwards, @p other only
+     * keeps empty items and should be deleted.
+     *
+     * If @p into is given, the costs of @p other are fused into this
+     * existing part instead. This is for a part loaded in chunks: all
+     * parts of @p other must use the same event columns as @p into.
+     */
+    void merge(TraceData* other, TracePart* into = nullptr);
+
+    /* Called after loading: releases spare capacity of the lists
+     * of dependencies and calls, which grow while loading, and the
+     * names interned by loaders (see releaseNames()).
+     */
+    void freeze();
+
     TracePartList parts() const { return _parts; }
     TracePart* partWithName(const QString& name);
 
@@ -1401,6 +1586,14 @@ public:
     // memory pools
     FixPool* fixPool();
     DynPool* dynPool();
+    // pool for cost items of type @p t, see TracePoolItem
+    FixPool* itemPool(ProfileContext::Type t);
+    // names of objects, files and functions seen by loaders
+    NamePool* namePool();
+    /* Free namePool() and the items remembered by name ID: items keep
+     * their names as QString. A later load interns names again.
+     */
+    void releaseNames();
 
     // factories for object/file/class/function/line instances
     TraceObject* object(const QString& name);
@@ -1411,6 +1604,22 @@ public:
     // factory for function cycles
     TraceFunctionCycle* functionCycle(TraceFunction*);
 
+    /**
+     * Same as above, with the name given as ID in namePool().
+     * Items are remembered by ID, so that a name seen again is
+     * resolved without converting it to a QString.
+     */
+    TraceObject* objectById(int nameId);
+    TraceFile* fileById(int nameId);
+    TraceFunction* functionById(int nameId, TraceFile*, TraceObject*);
+
+    /* Functions with names which can match the glob @p pattern of a
+     * search, in order of names, using a trigram index on function
+     * names built on first use. Returns false if the index can not
+     * narrow down the pattern: then all functions have to be checked.
+     */
+    bool functionCandidates(const QString& pattern, TraceFunctionList& list);
+
     /**
      * Search for item with given name and highest subcost of given cost type.
      *
@@ -1447,6 +1656,8 @@ public:
     int maxThreadID() const { return _maxThreadID; }
     void setMaxPartNumber(int n) { _maxPartNumber = n; }
     int maxPartNumber() const { return _maxPartNumber; }
+    // disable for data to be merged: parts get numbered on merge()
+    void setNumberParts(bool n) { _numberParts = n; }
 
     // reset all manually set directories for source files
     void resetSourceDirs();
@@ -1455,6 +1666,14 @@ public:
 
     // invalidates all cost items dependent on active state of parts
     void invalidateDynamicCost();
+    // update costs after activation of @p parts was changed
+    void updateActiveParts(const TracePartList& parts);
+    /* Update costs of all functions, calls, objects, classes and files
+     * in a pool of @p threads threads (0: GlobalConfig::loadThreads()),
+     * instead of one item at a time on first access. Used before views
+     * access the costs of all functions, e.g. for sorting.
+     */
+    void updateAll(int threads = 0);
 
     // cycle detection
     void updateFunctionCycles();
@@ -1462,32 +1681,60 @@ public:
     void updateClassCycles();
     void updateFileCycles();
     bool inFunctionCycleUpdate() { return _inFunctionCycleUpdate; }
+    // time of last function cycle detection in ms
+    int functionCycleTime() const { return _functionCycleTime; }
 
 private:
     void init();
+    void updateCalls(int threads);
     // add profile parts from one file
     int internalLoad(QIODevice* file, const QString& filename);
+    // load files in parallel, each into its own TraceData, and merge
+    int parallelLoad(const QStringList& files, int threads);
 
     // for notification callbacks
     Logger* _logger;
 
     TracePartList _parts;
+    // active state of parts, by part index
+    QBitArray _activeParts;
+    // range of active part indexes, -1 if not contiguous; see activeIndexRange()
+    int _activeFirst, _activeLast;
+    bool _activeRangeDirty;
 
     // The set for all costs
     EventTypeSet _eventTypes;
 
     FixPool* _fixPool;
     DynPool* _dynPool;
+    NamePool* _namePool;
+    FixPool* _itemPools[ProfileContext::MaxType];
+    // index on names in _functionMap, ids are positions in name order
+    NameIndex* _functionNameIndex;
+    QVector<TraceFunction*> _functionNameIndexItems;
 
     // always the trace totals (not dependent on active parts)
     ProfileCostArray _totals;
     int _maxThreadID;
     int _maxPartNumber;
+    // number parts without part number in addPart()?
+    bool _numberParts;
+    // followed files with position of last complete part loaded
+    bool _follow;
+    QMap<QString, LoaderPosition> _followed;
+    // set from another thread to abort loading
+    QAtomicInt _loadCanceled;
+    TraceData* _loadParent;
+    int _loadThreads;
 
     TraceObjectMap _objectMap;
     TraceClassMap _classMap;
     TraceFileMap _fileMap;
     TraceFunctionMap _functionMap;
+    // items by ID of name in _namePool
+    QVector<TraceObject*> _objectById;
+    QVector<TraceFile*> _fileById;
+    QHash<TraceFunctionKey, TraceFunction*> _functionById;
     QString _command;
     Arch _arch;
     QString _traceName;
@@ -1501,6 +1748,7 @@ private:
     TraceFunctionCycleList _functionCycles;
     int _functionCycleCount;
     bool _inFunctionCycleUpdate;
+    int _functionCycleTime;
 };
 
 
@@ -13,9 +13,24 @@
 #include "utils.h"
 
 #include <errno.h>
+#include <string.h>
 
 #include <QIODevice>
 #include <QFile>
+#include <QtAlgorithms>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+// AVX2 code is compiled in, and used depending on the CPU
+#define FIXFILE_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "compresseddevice.h"
+
+// size of decoded data kept in memory for compressed files
+#define FIXFILE_WINDOW (4*1024*1024)
 
 
 
@@ -61,70 +76,114 @@ bool FixString::stripPrefix(const char* p)
 }
 
 
-// this parses hexadecimal (with prefix '0x' too)
-bool FixString::stripUInt(unsigned int& v, bool stripSpaces)
+/* Number parsing for FixString
+ *
+ * Decimal digits are converted eight at once (SWAR: SIMD within a
+ * register) as long as at least 8 bytes are left in the string, the
+ * remaining ones one by one. Reads never go beyond the string length.
+ * Overflows wrap around the same way as with digit by digit conversion.
+ */
+
+static const uint64 powersOf10[9] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL,
+    100000ULL, 1000000ULL, 10000000ULL, 100000000ULL
+};
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+// value of 8 digits (already minus '0'), first one in lowest byte
+static inline uint64 eightDigits(uint64 val)
 {
-    if (_len==0) {
-        v = 0;
-        return false;
-    }
+    val = (val * 10) + (val >> 8);
+    val = (((val & 0x000000FF000000FFULL) * 0x000F424000000064ULL) +
+           (((val >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL)) >> 32;
+    return val;
+}
+#endif
 
-    char c = *_str;
-    if (c<'0' || c>'9') {
-        v = 0;
-        return false;
+template<class T>
+static inline void parseDecimal(const char*& s, int& l, T& v)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    while(l >= 8) {
+        uint64 chunk;
+        memcpy(&chunk, s, 8);
+        uint64 val = chunk - 0x3030303030303030ULL;
+        // high bit set for bytes below '0' or above '9'. Carries/borrows
+        // only start at such bytes, so the first one is found correctly
+        uint64 nonDigits = (val | (chunk + 0x4646464646464646ULL)) &
+                           0x8080808080808080ULL;
+        int n = nonDigits ? (qCountTrailingZeroBits(nonDigits) >> 3) : 8;
+        if (n == 0) return;
+
+        // shift out bytes after the digits, giving leading zeros
+        val <<= 8 * (8 - n);
+        v = v * (T) powersOf10[n] + (T) eightDigits(val);
+        s += n;
+        l -= n;
+        if (n < 8) return;
     }
+#endif
 
-    v = c-'0';
-    const char* s = _str+1;
-    int l = _len-1;
-    c = *s;
-
-    if ((l>0) && (c == 'x') && (v==0)) {
-        // hexadecimal
+    while((l > 0) && (*s >= '0') && (*s <= '9')) {
+        v = 10*v + (*s - '0');
         s++;
-        c = *s;
         l--;
+    }
+}
 
-        while(l>0) {
-            if (c>='0' && c<='9')
-                v = 16*v + (c-'0');
-            else if (c>='a' && c<='f')
-                v = 16*v + 10 + (c-'a');
-            else if (c>='A' && c<='F')
-                v = 16*v + 10 + (c-'A');
-            else
-                break;
-            s++;
-            c = *s;
-            l--;
-        }
+template<class T>
+static inline void parseHex(const char*& s, int& l, T& v)
+{
+    while(l > 0) {
+        char c = *s;
+        if (c>='0' && c<='9')
+            v = 16*v + (c-'0');
+        else if (c>='a' && c<='f')
+            v = 16*v + 10 + (c-'a');
+        else if (c>='A' && c<='F')
+            v = 16*v + 10 + (c-'A');
+        else
+            break;
+        s++;
+        l--;
     }
-    else {
-        // decimal
+}
 
-        while(l>0) {
-            if (c<'0' || c>'9') break;
-            v = 10*v + (c-'0');
-            s++;
-            c = *s;
-            l--;
-        }
+// this parses hexadecimal (with prefix '0x' too)
+template<class T>
+static inline bool stripNumber(const char*& str, int& len, T& v,
+                               bool stripSpaces)
+{
+    v = 0;
+    if ((len == 0) || (*str < '0') || (*str > '9'))
+        return false;
+
+    const char* s = str;
+    int l = len;
+    if ((l > 1) && (s[0] == '0') && (s[1] == 'x')) {
+        s += 2;
+        l -= 2;
+        parseHex(s, l, v);
     }
+    else
+        parseDecimal(s, l, v);
 
     if (stripSpaces)
-        while(l>0) {
-            if (c != ' ') break;
+        while((l > 0) && (*s == ' ')) {
             s++;
-            c = *s;
             l--;
         }
 
-    _str = s;
-    _len = l;
+    str = s;
+    len = l;
     return true;
 }
 
+bool FixString::stripUInt(unsigned int& v, bool stripSpaces)
+{
+    return stripNumber(_str, _len, v, stripSpaces);
+}
+
 
 void FixString::stripSurroundingSpaces()
 {
@@ -199,151 +258,98 @@ FixString FixString::stripUntil(char c)
 
 bool FixString::stripUInt64(uint64& v, bool stripSpaces)
 {
-    if (_len==0) {
-        v = 0;
-        return false;
-    }
-
-    char c = *_str;
-    if (c<'0' || c>'9') {
-        v = 0;
-        return false;
-    }
-
-    v = c-'0';
-    const char* s = _str+1;
-    int l = _len-1;
-    c = *s;
-
-    if ((l>0) && (c == 'x') && (v==0)) {
-        // hexadecimal
-        s++;
-        c = *s;
-        l--;
-
-        while(l>0) {
-            if (c>='0' && c<='9')
-                v = 16*v + (c-'0');
-            else if (c>='a' && c<='f')
-                v = 16*v + 10 + (c-'a');
-            else if (c>='A' && c<='F')
-                v = 16*v + 10 + (c-'A');
-            else
-                break;
-            s++;
-            c = *s;
-            l--;
-        }
-    }
-    else {
-        // decimal
-        while(l>0) {
-            if (c<'0' || c>'9') break;
-            v = 10*v + (c-'0');
-            s++;
-            c = *s;
-            l--;
-        }
-    }
-
-    if (stripSpaces)
-        while(l>0) {
-            if (c != ' ') break;
-            s++;
-            c = *s;
-            l--;
-        }
-
-    _str = s;
-    _len = l;
-    return true;
+    return stripNumber(_str, _len, v, stripSpaces);
 }
 
-
 bool FixString::stripInt64(int64& v, bool stripSpaces)
 {
-    if (_len==0) {
-        v = 0;
-        return false;
-    }
-
-    char c = *_str;
     bool negative = false;
-    if (c == '-') {
+    if ((_len > 0) && (*_str == '-')) {
         negative = true;
         _str++;
         _len--;
     }
-    if (_len==0) {
-        v = 0;
-        return false;
-    }
-    c = *_str;
-    if (c<'0' || c>'9') {
-        v = 0;
+
+    if (!stripNumber(_str, _len, v, stripSpaces))
         return false;
-    }
 
-    v = c-'0';
-    const char* s = _str+1;
-    int l = _len-1;
-    c = *s;
+    if (negative)
+        v = -v;
+    return true;
+}
+
 
-    if ((l>0) && (c == 'x') && (v==0)) {
-        // hexadecimal
+// class FixFile
+
+/* Line end search: position of first '\n' or '\0' in [s, end), or end.
+ * The SSE2 and AVX2 versions check 16/32 bytes at once; AVX2 is used
+ * if the CPU supports it (checked once at startup).
+ */
+static const char* findLineEndScalar(const char* s, const char* end)
+{
+    while((s < end) && (*s != '\n') && (*s != 0))
         s++;
-        c = *s;
-        l--;
+    return s;
+}
 
-        while(l>0) {
-            if (c>='0' && c<='9')
-                v = 16*v + (c-'0');
-            else if (c>='a' && c<='f')
-                v = 16*v + 10 + (c-'a');
-            else if (c>='A' && c<='F')
-                v = 16*v + 10 + (c-'A');
-            else
-                break;
-            s++;
-            c = *s;
-            l--;
-        }
+#if defined(__SSE2__) || defined(_M_X64)
+static const char* findLineEndSSE2(const char* s, const char* end)
+{
+    const __m128i nl = _mm_set1_epi8('\n');
+    const __m128i zero = _mm_setzero_si128();
+    while(end - s >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*) s);
+        uint mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, nl),
+                                                   _mm_cmpeq_epi8(v, zero)));
+        if (mask) return s + qCountTrailingZeroBits(mask);
+        s += 16;
     }
-    else {
-        // decimal
+    return findLineEndScalar(s, end);
+}
+#endif
 
-        while(l>0) {
-            if (c<'0' || c>'9') break;
-            v = 10*v + (c-'0');
-            s++;
-            c = *s;
-            l--;
-        }
+#if FIXFILE_AVX2
+__attribute__((target("avx2")))
+static const char* findLineEndAVX2(const char* s, const char* end)
+{
+    const __m256i nl = _mm256_set1_epi8('\n');
+    const __m256i zero = _mm256_setzero_si256();
+    while(end - s >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) s);
+        uint mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, nl),
+                                                         _mm256_cmpeq_epi8(v, zero)));
+        if (mask) return s + qCountTrailingZeroBits(mask);
+        s += 32;
     }
+    return findLineEndScalar(s, end);
+}
+#endif
 
-    if (negative)
-        v = -v;
-
-    if (stripSpaces)
-        while(l>0) {
-            if (c != ' ') break;
-            s++;
-            c = *s;
-            l--;
-        }
+typedef const char* (*FindLineEnd)(const char*, const char*);
 
-    _str = s;
-    _len = l;
-    return true;
+static FindLineEnd selectFindLineEnd()
+{
+#if FIXFILE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return findLineEndAVX2;
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    return findLineEndSSE2;
+#else
+    return findLineEndScalar;
+#endif
 }
 
+static const FindLineEnd findLineEnd = selectFindLineEnd();
 
 
-// class FixFile
-
 FixFile::FixFile(QIODevice* file, const QString& filename)
 {
     _file = file;
+    _stream = nullptr;
+    _streamEnd = false;
+    _start = 0;
 
     if (!file) {
         _len = 0;
@@ -365,6 +371,27 @@ FixFile::FixFile(QIODevice* file, const QString& filename)
     _openError = false;
     _used_mmap = false;
 
+    // compressed: decode windows of bounded size while reading lines
+    file->seek(0);
+    if (CompressedDevice::compression(file) != CompressedDevice::None) {
+        _stream = new CompressedDevice(file);
+        if (!_stream->open( QIODevice::ReadOnly )) {
+            qWarning( "%s: %s", (const char*)QFile::encodeName(_filename),
+                      qPrintable(_stream->errorString()) );
+            delete _stream;
+            _stream = nullptr;
+            _len = 0;
+            _currentLeft = 0;
+            _openError = true;
+            return;
+        }
+        _data.resize(FIXFILE_WINDOW);
+        _len = file->size();
+        _base = _current = _data.data();
+        _currentLeft = 0;
+        return;
+    }
+
     uchar* addr = nullptr;
 
 #if QT_VERSION >= 0x040400
@@ -387,7 +414,6 @@ FixFile::FixFile(QIODevice* file, const QString& filename)
     }
     else {
         // try reading the data into memory instead
-        file->seek(0);
         _data = file->readAll();
         _base = _data.data();
         _len  = _data.size();
@@ -397,9 +423,31 @@ FixFile::FixFile(QIODevice* file, const QString& filename)
     _currentLeft = _len;
 }
 
+FixFile::FixFile(const FixFile& file, qint64 start, qint64 end)
+{
+    // the data is owned by <file>
+    _file = nullptr;
+    _stream = nullptr;
+    _streamEnd = false;
+    _used_mmap = false;
+    _openError = file._openError;
+    _filename = file._filename;
+
+    if (start < 0) start = 0;
+    if (end > file._len) end = file._len;
+    if (end < start) end = start;
+
+    _base = file._base + start;
+    _start = file._start + start;
+    _len = end - start;
+    _current     = _base;
+    _currentLeft = _len;
+}
+
 FixFile::~FixFile()
 {
     // if the file was read into _data, it will be deleted automatically
+    delete _stream;
 
     if (_used_mmap && _file) {
         if (0) qDebug("Unmapping '%s'", qPrintable( _filename ));
@@ -414,16 +462,15 @@ FixFile::~FixFile()
 
 bool FixFile::nextLine(FixString& str)
 {
-    if (_currentLeft == 0) return false;
+    if (_stream) {
+        // make sure the window contains a complete line
+        while (!memchr(_current, '\n', _currentLeft) && refill()) {}
+    }
 
-    unsigned left = _currentLeft;
-    char* current = _current;
+    if (_currentLeft == 0) return false;
 
-    while(left>0) {
-        if (*current == 0 || *current == '\n') break;
-        current++;
-        left--;
-    }
+    char* current = (char*) findLineEnd(_current, _current + _currentLeft);
+    qint64 left = _currentLeft - (current - _current);
 
     if (0) {
         char tmp[200];
@@ -432,7 +479,7 @@ bool FixFile::nextLine(FixString& str)
         strncpy(tmp, _current, l);
         tmp[l] = 0;
         qDebug("[FixFile::nextLine] At %lu, len %u: '%s'",
-               (unsigned long) (_current - _base), _currentLeft-left, tmp);
+               (unsigned long) (_current - _base), (unsigned) (_currentLeft-left), tmp);
     }
 
     int len =  _currentLeft-left;
@@ -450,8 +497,21 @@ bool FixFile::nextLine(FixString& str)
     return true;
 }
 
-bool FixFile::setCurrent(unsigned pos)
+bool FixFile::setCurrent(qint64 pos)
 {
+    if (_stream) {
+        // decoding can only restart from the beginning
+        if (pos != 0) return false;
+
+        _stream->close();
+        _file->seek(0);
+        if (!_stream->open( QIODevice::ReadOnly )) return false;
+        _streamEnd = false;
+        _base = _current = _data.data();
+        _currentLeft = 0;
+        return true;
+    }
+
     if (pos > _len) return false;
 
     _current = _base + pos;
@@ -459,6 +519,36 @@ bool FixFile::setCurrent(unsigned pos)
     return true;
 }
 
+/* Move the incomplete line at the end of the window to its start,
+ * and append newly decoded data. The window grows for lines not
+ * fitting into it. Returns false if there is no more data.
+ */
+bool FixFile::refill()
+{
+    if (_streamEnd) return false;
+
+    qint64 offset = _current - _base;
+    if (_currentLeft == _data.size())
+        _data.resize(2 * _data.size());
+
+    char* base = _data.data();
+    if ((offset > 0) && (_currentLeft > 0))
+        memmove(base, base + offset, _currentLeft);
+
+    qint64 read = _stream->read(base + _currentLeft, _data.size() - _currentLeft);
+    if (read <= 0) {
+        if (read < 0)
+            qWarning( "%s: %s", (const char*)QFile::encodeName(_filename),
+                      qPrintable(_stream->errorString()) );
+        _streamEnd = true;
+        read = 0;
+    }
+
+    _base = _current = base;
+    _currentLeft += read;
+    return (read > 0);
+}
+
 
 #if 0
 
@@ -16,6 +16,7 @@
 #include <qstring.h>
 
 class QIODevice;
+class CompressedDevice;
 
 typedef unsigned long long uint64;
 typedef long long int64;
@@ -90,7 +91,19 @@ private:
 class FixFile {
 
 public:
+    /**
+     * Read lines from @p file. Compressed files are decoded in
+     * windows of bounded size while reading (see CompressedDevice);
+     * the string of a line then is only valid until the next call
+     * of nextLine().
+     */
     FixFile(QIODevice*, const QString&);
+    /**
+     * Read lines from a range [@p start, @p end) of already loaded @p file.
+     * The range must start at a line boundary, and @p file has to
+     * stay alive while using this reader.
+     */
+    FixFile(const FixFile& file, qint64 start, qint64 end);
     ~FixFile();
 
     /**
@@ -100,18 +113,28 @@ public:
      */
     bool nextLine(FixString& str);
     bool exists() { return !_openError; }
-    unsigned len() { return _len; }
-    unsigned current() { return _current - _base; }
-    bool setCurrent(unsigned pos);
+    // streamed data: len() and current() refer to the compressed file
+    bool isStreamed() const { return _stream != nullptr; }
+    qint64 len() { return _len; }
+    qint64 current() { return _stream ? _file->pos() : _current - _base; }
+    // offset of the range read in the whole file, see range constructor
+    qint64 start() const { return _start; }
+    // streamed data only can be rewound
+    bool setCurrent(qint64 pos);
     void rewind() { setCurrent(0); }
 
 private:
+    bool refill();
+
     char *_base, *_current;
     QByteArray _data;
-    unsigned _len, _currentLeft;
+    qint64 _len, _currentLeft, _start;
     bool _used_mmap, _openError;
     QIODevice* _file;
     QString _filename;
+    // decoder for compressed files, _data is the window
+    CompressedDevice* _stream;
+    bool _streamEnd;
 };
 
 
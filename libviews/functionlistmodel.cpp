@@ -8,6 +8,8 @@
 
 #include "functionlistmodel.h"
 
+#include <QSet>
+
 #include "globalguiconfig.h"
 #include "listutils.h"
 
@@ -49,6 +51,7 @@ FunctionListModel::FunctionListModel()
             << tr("Location");
 
     _max0 = _max1 = _max2 = nullptr;
+    _group = nullptr;
 }
 
 FunctionListModel::~FunctionListModel()
@@ -227,11 +230,14 @@ void FunctionListModel::resetModelData(TraceData *data,
                                        EventType * eventType)
 {
     _eventType = eventType;
+    _group = group;
 
     if (!group) {
         _list.clear();
         _groupType = ProfileContext::Function;
         if (data) {
+            // sorting needs costs of all functions: update them in parallel
+            data->updateAll();
             TraceFunctionMap::iterator i = data->functionMap().begin();
             while (i != data->functionMap().end()) {
                 _list.append(&(i.value()));
@@ -290,6 +296,18 @@ void FunctionListModel::resetModelData(TraceData *data,
     computeTopList();
 }
 
+bool FunctionListModel::inGroup(TraceFunction* f) const
+{
+    switch(_groupType) {
+    case ProfileContext::Object:        return f->object() == _group;
+    case ProfileContext::Class:         return f->cls() == _group;
+    case ProfileContext::File:          return f->file() == _group;
+    case ProfileContext::FunctionCycle: return f->cycle() == _group;
+    default: break;
+    }
+    return false;
+}
+
 void FunctionListModel::computeFilteredList()
 {
     FunctionLessThan lessThan0(0, Qt::AscendingOrder, _eventType);
@@ -301,18 +319,57 @@ void FunctionListModel::computeFilteredList()
     _max1 = nullptr;
     _max2 = nullptr;
 
+    // only check functions found in the name index with the filter
+    bool useFilter = !_filterString.isEmpty() && _filter.isValid();
+    TraceFunctionList candidates;
+    bool narrowed = false;
+    if (useFilter && !_list.isEmpty()) {
+        TraceData* d = _list.first()->data();
+        if (d && d->functionCandidates(_filterString, candidates)) {
+            narrowed = true;
+            if (!_group) {
+                // cycles are not in the index
+                foreach(TraceFunction* f, d->functionCycles())
+                    candidates.append(f);
+            }
+        }
+    }
+
     _filteredList.clear();
     int index = 0;
-    foreach(TraceFunction* f, _list) {
-        if (!_filterString.isEmpty() && _filter.isValid())
-            if (!f->name().contains(_filter)) continue;
+    foreach(TraceFunction* f, narrowed ? candidates : _list) {
+        if (narrowed && _group && !inGroup(f)) continue;
+        if (useFilter && !f->name().contains(_filter)) continue;
 
         _filteredList.append(f);
-        if (!_max0 || lessThan0(_max0, f)) { _max0 = f; }
-        if (!_max1 || lessThan1(_max1, f)) { _max1 = f; }
+        if (!_eventType) {
+            if (!_max0 || lessThan0(_max0, f)) { _max0 = f; }
+            if (!_max1 || lessThan1(_max1, f)) { _max1 = f; }
+        }
         if (!_max2 || lessThan2(_max2, f)) { _max2 = f; }
         index++;
     }
+
+    if (_eventType && !_filteredList.isEmpty()) {
+        CostColumns columns;
+        fillColumns(columns, true);
+        _max0 = _filteredList.at(columns.maxRow(_eventType));
+        fillColumns(columns, false);
+        _max1 = _filteredList.at(columns.maxRow(_eventType));
+    }
+}
+
+void FunctionListModel::fillColumns(CostColumns& columns, bool inclusive)
+{
+    QList<ProfileCostArray*> items;
+    items.reserve(_filteredList.count());
+    foreach(TraceFunction* f, _filteredList) {
+        if (inclusive)
+            items.append(f->inclusive());
+        else
+            items.append(f);
+    }
+    columns.set(items, _eventType->set()->realCount());
 }
 
 void FunctionListModel::computeTopList()
@@ -325,7 +382,20 @@ void FunctionListModel::computeTopList()
     }
 
     FunctionLessThan lessThan(_sortColumn, _sortOrder, _eventType);
-    std::stable_sort(_filteredList.begin(), _filteredList.end(), lessThan);
+    if (_eventType && (_sortColumn == 0 || _sortColumn == 1)) {
+        // sort by cost: get the keys of all candidates in one pass
+        CostColumns columns;
+        fillColumns(columns, _sortColumn == 0);
+        QVector<int> rows = columns.order(_eventType,
+                                          _sortOrder == Qt::DescendingOrder);
+        QList<TraceFunction*> sorted;
+        sorted.reserve(rows.count());
+        foreach(int row, rows)
+            sorted.append(_filteredList.at(row));
+        _filteredList = sorted;
+    }
+    else
+        std::stable_sort(_filteredList.begin(), _filteredList.end(), lessThan);
 
     foreach(TraceFunction* f, _filteredList) {
         _topList.append(f);
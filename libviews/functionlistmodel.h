@@ -16,6 +16,7 @@
 
 #include "tracedata.h"
 #include "subcost.h"
+#include "costcolumns.h"
 
 // helper for setting function filter
 QString glob2Regex(QString pattern);
@@ -82,12 +83,17 @@ private:
 
     // compute the list of candidates to show, ignoring order
     void computeFilteredList();
+    // is function in the group shown?
+    bool inGroup(TraceFunction*) const;
     // computes entries to show from candidates using current order
     void computeTopList();
+    // snapshot of inclusive or self costs of candidates, in list order
+    void fillColumns(CostColumns&, bool inclusive);
 
     QList<QVariant> _headerData;
     EventType *_eventType;
     ProfileContext::Type _groupType;
+    TraceCostItem* _group;
     int _maxCount;
 
     QList<TraceFunction*> _list;
@@ -611,33 +611,34 @@ void FunctionSelection::refresh()
 
     _hc.clear(GlobalConfig::maxListCount());
 
+    QList<ProfileCostArray*> groups;
     switch(_groupType) {
     case ProfileContext::Object:
 
         for ( oit = _data->objectMap().begin();
               oit != _data->objectMap().end(); ++oit )
-            _hc.addCost(&(*oit), (*oit).subCost(_eventType));
+            groups.append(&(*oit));
         break;
 
     case ProfileContext::Class:
 
         for ( cit = _data->classMap().begin();
               cit != _data->classMap().end(); ++cit )
-            _hc.addCost(&(*cit), (*cit).subCost(_eventType));
+            groups.append(&(*cit));
         break;
 
     case ProfileContext::File:
 
         for ( fit = _data->fileMap().begin();
               fit != _data->fileMap().end(); ++fit )
-            _hc.addCost(&(*fit), (*fit).subCost(_eventType));
+            groups.append(&(*fit));
         break;
 
     case ProfileContext::FunctionCycle:
     {
         // add all cycles
         foreach(TraceCostItem *group, _data->functionCycles())
-            _hc.addCost(group, group->subCost(_eventType));
+            groups.append(group);
     }
 
         break;
@@ -652,6 +653,14 @@ void FunctionSelection::refresh()
     }
     }
 
+    // evaluate the event type for all groups in one batch; this also
+    // fills the cost cache of the groups used by the list items
+    QVector<SubCost> groupCosts(groups.count());
+    if (_eventType)
+        _eventType->subCosts(groups, groupCosts.data());
+    for (int i = 0; i < groups.count(); i++)
+        _hc.addCost(groups.at(i), groupCosts.at(i));
+
     // update group from _activeItem if possible
     if (_activeItem && (_activeItem->type() == _groupType))
         _group = (TraceCostItem*) _activeItem;
@@ -809,10 +818,19 @@ void FunctionSelection::query(QString query)
 
     _hc.clear(GlobalConfig::maxListCount());
 
-    TraceFunctionMap::Iterator it;
-    for ( it = _data->functionMap().begin();
-          it != _data->functionMap().end(); ++it ) {
-        f = &(*it);
+    // the name index can narrow down the functions to check if pretty
+    // names are the function names
+    TraceFunctionList candidates;
+    if (GlobalConfig::hideTemplates() ||
+        !_data->functionCandidates(query, candidates)) {
+        candidates.clear();
+        TraceFunctionMap::Iterator it;
+        for ( it = _data->functionMap().begin();
+              it != _data->functionMap().end(); ++it )
+            candidates.append(&(*it));
+    }
+
+    foreach(f, candidates) {
         if (re.isValid() && f->prettyName().contains(re)) {
             if (_group) {
                 if (_groupType==ProfileContext::Object) {
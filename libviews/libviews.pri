@@ -9,6 +9,7 @@ NHEADERS += \
     $$PWD/functionlistmodel.h \
     $$PWD/functionselection.h \
     $$PWD/listutils.h \
+    $$PWD/loadthread.h \
     $$PWD/stackselection.h \
     $$PWD/multiview.h \
     $$PWD/tabview.h \
@@ -47,6 +48,7 @@ SOURCES += \
     $$PWD/instritem.cpp \
     $$PWD/instrview.cpp \
     $$PWD/listutils.cpp \
+    $$PWD/loadthread.cpp \
     $$PWD/multiview.cpp \
     $$PWD/partgraph.cpp \
     $$PWD/partlistitem.cpp \
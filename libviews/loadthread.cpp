@@ -0,0 +1,113 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-FileCopyrightText: 2026 KCachegrind Authors
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Loading of profile data in a background thread
+ */
+
+#include "loadthread.h"
+
+#include <QIODevice>
+
+#include "tracedata.h"
+
+
+LoadThread::LoadThread(const QStringList& files, QIODevice* device,
+                       QObject* parent)
+    : QThread(parent)
+{
+    _files = files;
+    _device = device;
+    _data = new TraceData(this);
+    _partsLoaded = 0;
+    _discarded = false;
+
+    // connected before start, so a finish is never missed by discard()
+    connect(this, &QThread::finished, this, [this]() {
+        if (_discarded) deleteLater();
+    });
+}
+
+LoadThread::~LoadThread()
+{
+    cancel();
+    wait();
+
+    delete _data;
+    delete _device;
+}
+
+void LoadThread::cancel()
+{
+    if (_data) _data->cancelLoad();
+}
+
+void LoadThread::discard()
+{
+    _discarded = true;
+    cancel();
+    setParent(nullptr);
+    // calling deleteLater() again from the finish handler is harmless
+    if (!isRunning()) deleteLater();
+}
+
+bool LoadThread::canceled() const
+{
+    return _data && _data->loadCanceled();
+}
+
+TraceData* LoadThread::takeData(Logger* l)
+{
+    if (!isFinished() || !_data) return nullptr;
+
+    if (_data->loadCanceled()) {
+        delete _data;
+        _data = nullptr;
+        return nullptr;
+    }
+
+    TraceData* d = _data;
+    _data = nullptr;
+    d->setLogger(l);
+    return d;
+}
+
+void LoadThread::run()
+{
+    if (_files.isEmpty()) return;
+
+    if (_device)
+        _partsLoaded = _data->load(_device, _files.first());
+    else
+        _partsLoaded = _data->load(_files);
+}
+
+void LoadThread::loadStart(const QString& filename)
+{
+    emit startedFile(filename);
+}
+
+void LoadThread::loadProgress(int progress)
+{
+    emit progressed(progress);
+}
+
+void LoadThread::loadWarning(int line, const QString& msg)
+{
+    emit warning(line, msg);
+}
+
+void LoadThread::loadError(int line, const QString& msg)
+{
+    emit error(line, msg);
+}
+
+void LoadThread::loadFinished(const QString& msg)
+{
+    emit finishedFile(msg);
+}
@@ -0,0 +1,88 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-FileCopyrightText: 2026 KCachegrind Authors
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Loading of profile data in a background thread
+ */
+
+#ifndef LOADTHREAD_H
+#define LOADTHREAD_H
+
+#include <QThread>
+#include <QStringList>
+
+#include "logger.h"
+
+class QIODevice;
+class TraceData;
+
+/**
+ * Loads profile data into a new TraceData in its own thread, keeping
+ * the GUI responsive. Notifications of the loader are delivered as
+ * signals, i.e. queued into the thread of a connected receiver.
+ *
+ * The data is not attached to any view while loading. After
+ * finished(), takeData() passes ownership of the data to the caller,
+ * unless the load was canceled: then the partial data is freed here.
+ */
+class LoadThread: public QThread, public Logger
+{
+    Q_OBJECT
+
+public:
+    // with @p device given, it is loaded instead of the files (owned)
+    explicit LoadThread(const QStringList& files,
+                        QIODevice* device = nullptr,
+                        QObject* parent = nullptr);
+    ~LoadThread() override;
+
+    QStringList files() const { return _files; }
+    // data being loaded, only to be configured before start()
+    TraceData* data() const { return _data; }
+
+    // abort loading, safe to call from the GUI thread at any time
+    void cancel();
+    /* Abort loading and delete this thread once it finished, without
+     * waiting. It gets detached from its parent to possibly outlive it.
+     */
+    void discard();
+    bool canceled() const;
+    int partsLoaded() const { return _partsLoaded; }
+
+    /**
+     * After the thread finished, return the loaded data with @p l as
+     * new logger, or nullptr if loading was canceled.
+     */
+    TraceData* takeData(Logger* l);
+
+    // Logger interface, called in the loading thread
+    void loadStart(const QString& filename) override;
+    void loadProgress(int progress) override;
+    void loadWarning(int line, const QString& msg) override;
+    void loadError(int line, const QString& msg) override;
+    void loadFinished(const QString& msg) override;
+
+Q_SIGNALS:
+    void startedFile(const QString& filename);
+    void progressed(int progress);
+    void warning(int line, const QString& msg);
+    void error(int line, const QString& msg);
+    void finishedFile(const QString& msg);
+
+protected:
+    void run() override;
+
+private:
+    QStringList _files;
+    QIODevice* _device;
+    TraceData* _data;
+    int _partsLoaded;
+    bool _discarded;
+};
+
+#endif // LOADTHREAD_H
@@ -24,8 +24,12 @@
 #include <QLabel>
 #include <QMenuBar>
 #include <QProgressBar>
+#include <QRegularExpression>
+#include <QPushButton>
 #include <QFile>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QLineEdit>
 #include <QEventLoop>
 #include <QToolBar>
 #include <QComboBox>
@@ -48,6 +52,7 @@
 #include "multiview.h"
 #include "callgraphview.h"
 #include "configdialog.h"
+#include "loadthread.h"
 
 QCGTopLevel::QCGTopLevel()
 {
@@ -61,6 +66,13 @@ QCGTopLevel::QCGTopLevel()
     _statusbar = statusBar();
     _statusLabel = new QLabel(_statusbar);
     _statusbar->addWidget(_statusLabel, 1);
+    _cancelButton = new QPushButton(tr("Cancel"), _statusbar);
+    _cancelButton->setToolTip(tr("Cancel loading of profile data"));
+    _statusbar->addPermanentWidget(_cancelButton);
+    _cancelButton->hide();
+    connect(_cancelButton, &QPushButton::clicked,
+            this, &QCGTopLevel::cancelLoad);
+    _loadThread = nullptr;
 
     _layoutCount = 1;
     _layoutCurrent = 0;
@@ -116,6 +128,11 @@ QCGTopLevel::~QCGTopLevel()
         }
     }
 #endif
+    // a running load finishes in the background
+    if (_loadThread) {
+        _loadThread->disconnect(this);
+        _loadThread->discard();
+    }
     delete _data;
 }
 
@@ -378,6 +395,12 @@ void QCGTopLevel::createActions()
     _addAction->setStatusTip(tr("Add profile data to current window"));
     connect(_addAction, SIGNAL(triggered(bool)), SLOT(add()));
 
+    _loadEventsAction = new QAction(tr("Select &Events to Load..."), this);
+    _loadEventsAction->setStatusTip(tr("Only load selected event types "
+                                       "from profile data files"));
+    connect(_loadEventsAction, &QAction::triggered,
+            this, &QCGTopLevel::selectLoadEvents);
+
     _exportAction = new QAction(tr("Export Graph"), this);
     _exportAction->setStatusTip(tr("Generate GraphViz file 'callgraph.dot'"));
     connect(_exportAction, &QAction::triggered, this, &QCGTopLevel::exportGraph);
@@ -610,6 +633,7 @@ void QCGTopLevel::createMenu()
     fileMenu->addAction(_openAction);
     fileMenu->addAction(_recentFilesMenuAction);
     fileMenu->addAction(_addAction);
+    fileMenu->addAction(_loadEventsAction);
     fileMenu->addSeparator();
     fileMenu->addAction(_exportAction);
     fileMenu->addSeparator();
@@ -866,11 +890,57 @@ void QCGTopLevel::load(QStringList files, bool addToRecentFiles)
         return;
     }
 
-    // this constructor enables progress bar callbacks
-    TraceData* d = new TraceData(this);
-    int filesLoaded = d->load(files);
+    startLoad(files, addToRecentFiles);
+}
+
+void QCGTopLevel::startLoad(const QStringList& files, bool addToRecentFiles)
+{
+    if (_loadThread) {
+        // no notifications from the replaced load any more
+        _loadThread->disconnect(this);
+        _loadThread->discard();
+        showStatus(QString(), 0);
+    }
+    LoadThread* thread = new LoadThread(files, nullptr, this);
+    _loadThread = thread;
+
+    // loader notifications are queued into the GUI thread
+    connect(thread, &LoadThread::startedFile, this, &QCGTopLevel::loadStart);
+    connect(thread, &LoadThread::progressed, this, &QCGTopLevel::loadProgress);
+    connect(thread, &LoadThread::warning, this, &QCGTopLevel::loadWarning);
+    connect(thread, &LoadThread::error, this, &QCGTopLevel::loadError);
+    connect(thread, &LoadThread::finishedFile, this, &QCGTopLevel::loadFinished);
+    // a replaced thread is deleted only after this was delivered (see
+    // LoadThread::discard()), so no new thread can be at its address
+    connect(thread, &QThread::finished, this, [this, thread, addToRecentFiles]() {
+        loadThreadFinished(thread, addToRecentFiles);
+    });
+
+    _cancelButton->show();
+    thread->start();
+}
+
+void QCGTopLevel::loadThreadFinished(LoadThread* thread, bool addToRecentFiles)
+{
+    if (thread != _loadThread) return;
+    _loadThread = nullptr;
+    _cancelButton->hide();
+    showStatus(QString(), 0);
+
+    // views only get to see completely loaded data
+    TraceData* d = thread->takeData(this);
+    int filesLoaded = thread->partsLoaded();
+    QStringList files = thread->files();
+    thread->deleteLater();
+
+    if (!d) {
+        showMessage(tr("Loading canceled"), 2000);
+        return;
+    }
     if (filesLoaded >0)
         setData(d);
+    else
+        delete d;
 
     if (!addToRecentFiles) return;
 
@@ -890,6 +960,12 @@ void QCGTopLevel::load(QStringList files, bool addToRecentFiles)
     delete generalConfig;
 }
 
+void QCGTopLevel::cancelLoad()
+{
+    if (_loadThread)
+        _loadThread->cancel();
+}
+
 
 void QCGTopLevel::add()
 {
@@ -915,11 +991,7 @@ void QCGTopLevel::add(QStringList files)
         return;
     }
 
-    // this constructor enables progress bar callbacks
-    TraceData* d = new TraceData(this);
-    int filesLoaded = d->load(files);
-    if (filesLoaded >0)
-        setData(d);
+    startLoad(files, false);
 }
 
 void QCGTopLevel::loadDelayed(QString file, bool addToRecentFiles)
@@ -947,6 +1019,20 @@ void QCGTopLevel::loadFilesDelayed()
 }
 
 
+void QCGTopLevel::selectLoadEvents()
+{
+    bool ok;
+    QString events = GlobalConfig::loadEvents().join(QLatin1Char(' '));
+    events = QInputDialog::getText(this, tr("Select Events to Load"),
+                                   tr("Event types to load from the next "
+                                      "opened files (empty for all):"),
+                                   QLineEdit::Normal, events, &ok);
+    if (!ok) return;
+
+    GlobalConfig::setLoadEvents(events.split(QRegularExpression(QStringLiteral("[\\s,]+")),
+                                             Qt::SkipEmptyParts));
+}
+
 void QCGTopLevel::exportGraph()
 {
     if (!_data || !_function) return;
@@ -29,9 +29,11 @@ class QDockWidget;
 class QLabel;
 class QComboBox;
 class QProgressBar;
+class QPushButton;
 class QMenu;
 
 class TraceData;
+class LoadThread;
 class MainWidget;
 class PartSelection;
 class FunctionSelection;
@@ -85,6 +87,7 @@ public Q_SLOTS:
     void loadDelayed(QStringList files, bool addToRecentFiles = true);
 
     void exportGraph();
+    void selectLoadEvents();
     void newWindow();
     void configure(QString page = QString());
     void about();
@@ -174,6 +177,9 @@ public Q_SLOTS:
     void loadFilesDelayed();
     void setDirectionDelayed();
 
+    // abort loading in the background
+    void cancelLoad();
+
     // configuration has changed
     void configChanged() override;
 
@@ -196,12 +202,17 @@ private:
     QString traceKey();
     void restoreTraceTypes();
     void restoreTraceSettings();
+    // load @p files in the background, replacing a load in progress
+    void startLoad(const QStringList& files, bool addToRecentFiles);
+    void loadThreadFinished(LoadThread* thread, bool addToRecentFiles);
 
     QStatusBar* _statusbar;
     QLabel* _statusLabel;
     QString _progressMsg;
     QElapsedTimer _progressStart;
     QProgressBar* _progressBar;
+    QPushButton* _cancelButton;
+    LoadThread* _loadThread;
 
     MultiView* _multiView;
     Qt::Orientation _spOrientation;
@@ -215,6 +226,7 @@ private:
     // menu/toolbar actions
     QAction *_newAction, *_openAction, *_addAction, *_reloadAction;
     QAction *_exportAction, *_dumpToggleAction, *_exitAction;
+    QAction *_loadEventsAction;
     QAction *_sidebarMenuAction, *_recentFilesMenuAction;
     QAction *_cyclesToggleAction, *_percentageToggleAction;
     QAction *_expandedToggleAction, *_hideTemplatesToggleAction;
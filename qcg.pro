@@ -14,4 +14,4 @@ lessThan(QT_MAJOR_VERSION, 6) {
 
 
 TEMPLATE = subdirs
-SUBDIRS = cgview qcachegrind
+SUBDIRS = cgview cgbench qcachegrind